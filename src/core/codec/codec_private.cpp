@@ -0,0 +1,114 @@
+#include "codec_private.h"
+
+#include <endian.h>
+
+namespace kim {
+
+CodecPrivate::CodecPrivate(std::shared_ptr<Log> logger, Codec::TYPE codec)
+    : Codec(logger, codec) {
+}
+
+Codec::STATUS CodecPrivate::peek_head(SocketBuffer* sbuf, private_head_t& head) {
+    if (sbuf->readable_len() < PRIVATE_MSG_HEAD_LEN) {
+        return Codec::STATUS::PAUSE;
+    }
+
+    memcpy(&head, sbuf->raw_read_buffer(), PRIVATE_MSG_HEAD_LEN);
+    head.cmd = le32toh(head.cmd);
+    head.seq = le32toh(head.seq);
+    head.len = (int32_t)le32toh((uint32_t)head.len);
+    head.route_key = le32toh(head.route_key);
+
+    if (head.len < 0 || head.len > PRIVATE_MSG_MAX_BODY_LEN) {
+        return Codec::STATUS::ERR;
+    }
+    return Codec::STATUS::OK;
+}
+
+void CodecPrivate::write_head(const private_head_t& head, char* buf) {
+    private_head_t h;
+    h.cmd = htole32(head.cmd);
+    h.seq = htole32(head.seq);
+    h.len = (int32_t)htole32((uint32_t)head.len);
+    h.route_key = htole32(head.route_key);
+    memcpy(buf, &h, PRIVATE_MSG_HEAD_LEN);
+}
+
+Codec::STATUS CodecPrivate::encode(std::shared_ptr<Msg> msg, SocketBuffer* sbuf) {
+    if (sbuf == nullptr || msg == nullptr) {
+        LOG_ERROR("invalid param!");
+        return CodecPrivate::STATUS::ERR;
+    }
+
+    auto head = msg->head();
+
+    /* msg maybe has empty body, like heartbeat. the body is sized only here, senders don't
+     * set head's len. ByteSizeLong() refreshes the nested cached sizes for SerializeWithCachedSizesToArray(). */
+    size_t body_len = msg->is_raw() ? msg->raw_body().size() : msg->body()->ByteSizeLong();
+
+    if (!sbuf->ensure_writeable(PRIVATE_MSG_HEAD_LEN + body_len)) {
+        LOG_ERROR("alloc buffer failed! cmd: %d, seq: %d, body len: %lu",
+                  head->cmd(), head->seq(), body_len);
+        return CodecPrivate::STATUS::ERR;
+    }
+
+    char* p = sbuf->raw_write_buffer();
+    write_head({head->cmd(), head->seq(), (int32_t)body_len, msg->route_key()}, p);
+
+    if (body_len > 0 && msg->is_raw()) {
+        memcpy(p + PRIVATE_MSG_HEAD_LEN, msg->raw_body().data(), body_len);
+    } else if (body_len > 0) {
+        uint8_t* end = msg->body()->SerializeWithCachedSizesToArray((uint8_t*)p + PRIVATE_MSG_HEAD_LEN);
+        if ((size_t)(end - (uint8_t*)p) != PRIVATE_MSG_HEAD_LEN + body_len) {
+            LOG_ERROR("encode body failed! cmd: %d, seq: %d, body len: %lu",
+                      head->cmd(), head->seq(), body_len);
+            return CodecPrivate::STATUS::ERR;
+        }
+    }
+
+    sbuf->advance_write_index(PRIVATE_MSG_HEAD_LEN + body_len);
+    return CodecPrivate::STATUS::OK;
+}
+
+Codec::STATUS CodecPrivate::decode(SocketBuffer* sbuf, std::shared_ptr<Msg> msg) {
+    if (sbuf == nullptr || msg == nullptr) {
+        LOG_ERROR("invalid param");
+        return CodecPrivate::STATUS::ERR;
+    }
+
+    private_head_t h;
+    auto status = peek_head(sbuf, h);
+    if (status != Codec::STATUS::OK) {
+        if (status == Codec::STATUS::ERR) {
+            LOG_ERROR("invalid head! cmd: %u, seq: %u, len: %d", h.cmd, h.seq, h.len);
+        }
+        return status;
+    }
+
+    if ((int)sbuf->readable_len() < PRIVATE_MSG_HEAD_LEN + h.len) {
+        /* wait for more data to decode. */
+        return CodecPrivate::STATUS::PAUSE;
+    }
+
+    auto head = msg->head();
+    head->set_cmd(h.cmd);
+    head->set_seq(h.seq);
+    head->set_len(h.len);
+    msg->set_route_key(h.route_key);
+
+    /* msg body maybe empty, like heartbeat. */
+    if (msg->is_raw()) {
+        /* pass-through, keep the body undecoded. */
+        msg->set_raw_body(sbuf->raw_read_buffer() + PRIVATE_MSG_HEAD_LEN, h.len);
+    } else if (h.len > 0) {
+        if (!msg->body()->ParseFromArray(sbuf->raw_read_buffer() + PRIVATE_MSG_HEAD_LEN, h.len)) {
+            LOG_ERROR("cmd: %u, seq: %u, parse msg body failed!", h.cmd, h.seq);
+            return CodecPrivate::STATUS::ERR;
+        }
+    }
+
+    sbuf->skip_bytes(PRIVATE_MSG_HEAD_LEN + h.len);
+    return CodecPrivate::STATUS::OK;
+}
+
+}  // namespace kim
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "../server.h"
+#include "codec.h"
+
+namespace kim {
+
+/**
+ *       +-------------+-------------+
+ *       | private head|    MsgBody  |
+ *       +-------------+-------------+
+ *       +-  16 bytes -+
+ *
+ * head: cmd | seq | len | route_key, 4 bytes each, packed, little-endian.
+ * it is read by plain loads, no protobuf parsing for the head.
+ * route_key: set by client (e.g. a hash of user id), gate routes the msg to
+ * a logic node by it without reading the body, 0: route by body's data.
+ */
+
+#define PRIVATE_MSG_HEAD_LEN 16
+#define PRIVATE_MSG_MAX_BODY_LEN (64 * 1024 * 1024)
+
+typedef struct private_head_s {
+    uint32_t cmd;
+    uint32_t seq;
+    int32_t len;
+    uint32_t route_key;
+} __attribute__((packed)) private_head_t;
+
+static_assert(sizeof(private_head_t) == PRIVATE_MSG_HEAD_LEN, "invalid private head len!");
+
+class CodecPrivate : public Codec {
+   public:
+    CodecPrivate(std::shared_ptr<Log> logger, Codec::TYPE codec);
+    virtual ~CodecPrivate() {}
+
+    virtual Codec::STATUS decode(SocketBuffer* sbuf, std::shared_ptr<Msg> msg) override;
+    virtual Codec::STATUS encode(std::shared_ptr<Msg> msg, SocketBuffer* sbuf) override;
+
+   private:
+    /* read the head of the first frame in buffer, the buffer's read index is not moved. */
+    static Codec::STATUS peek_head(SocketBuffer* sbuf, private_head_t& head);
+    static void write_head(const private_head_t& head, char* buf);
+};
+
+}  // namespace kim
@@ -1,7 +1,11 @@
 #include "codec_proto.h"
 
+#include <google/protobuf/wire_format_lite.h>
+
 #define PROTO_MSG_HEAD_LEN 15
 
+using google::protobuf::internal::WireFormatLite;
+
 namespace kim {
 
 CodecProto::CodecProto(std::shared_ptr<Log> logger, Codec::TYPE codec)
@@ -15,31 +19,41 @@ Codec::STATUS CodecProto::encode(std::shared_ptr<Msg> msg, SocketBuffer* sbuf) {
     }
 
     auto head = msg->head();
-    auto body = msg->body();
-    auto body_len = body->ByteSizeLong();
 
-    auto write_len = sbuf->_write(head->SerializeAsString().c_str(), PROTO_MSG_HEAD_LEN);
-    if (write_len != PROTO_MSG_HEAD_LEN) {
-        LOG_ERROR("encode head failed!, cmd: %d, seq: %d",
-                  head->cmd(), head->seq());
+    /* msg maybe has empty body, like heartbeat. the body is sized only here,
+     * senders don't set head's len. ByteSizeLong() refreshes the nested cached
+     * sizes which are used by SerializeWithCachedSizesToArray(), Clear() and parsing don't. */
+    size_t body_len = msg->is_raw() ? msg->raw_body().size() : msg->body()->ByteSizeLong();
+
+    if (!sbuf->ensure_writeable(PROTO_MSG_HEAD_LEN + body_len)) {
+        LOG_ERROR("alloc buffer failed! cmd: %d, seq: %d, body len: %lu",
+                  head->cmd(), head->seq(), body_len);
         return CodecProto::STATUS::ERR;
     }
 
-    auto len = write_len;
-
-    if (head->len() <= 0) {
-        // msg maybe has empty body, like heartbeat.
-        return CodecProto::STATUS::OK;
+    /* serialize in place, head always takes 15 bytes even if a field is zero. */
+    uint8_t* start = (uint8_t*)sbuf->raw_write_buffer();
+    uint8_t* p = start;
+    p = WireFormatLite::WriteFixed32ToArray(MsgHead::kCmdFieldNumber, head->cmd(), p);
+    p = WireFormatLite::WriteFixed32ToArray(MsgHead::kSeqFieldNumber, head->seq(), p);
+    p = WireFormatLite::WriteSFixed32ToArray(MsgHead::kLenFieldNumber, (int32_t)body_len, p);
+
+    if (body_len > 0) {
+        if (msg->is_raw()) {
+            memcpy(p, msg->raw_body().data(), body_len);
+            p += body_len;
+        } else {
+            p = msg->body()->SerializeWithCachedSizesToArray(p);
+        }
     }
 
-    write_len = sbuf->_write(body->SerializeAsString().c_str(), body_len);
-    if (write_len != (int)body_len) {
+    if ((size_t)(p - start) != PROTO_MSG_HEAD_LEN + body_len) {
         LOG_ERROR("encode failed! cmd: %d, seq: %d, write len: %d, body len: %lu",
-                  head->cmd(), head->seq(), write_len, body_len);
-        sbuf->set_write_index(sbuf->write_index() - len);
+                  head->cmd(), head->seq(), (int)(p - start), body_len);
         return CodecProto::STATUS::ERR;
     }
 
+    sbuf->advance_write_index(PROTO_MSG_HEAD_LEN + body_len);
     return CodecProto::STATUS::OK;
 }
 
@@ -50,7 +64,6 @@ Codec::STATUS CodecProto::decode(SocketBuffer* sbuf, std::shared_ptr<Msg> msg) {
     }
 
     auto head = msg->head();
-    auto body = msg->body();
 
     // LOG_TRACE("decode data len: %d, cur read index: %d, write index: %d",
     //           sbuf->readable_len(), sbuf->read_index(), sbuf->write_index());
@@ -70,6 +83,9 @@ Codec::STATUS CodecProto::decode(SocketBuffer* sbuf, std::shared_ptr<Msg> msg) {
 
     // msg body maybe empty, like heartbeat.
     if (head->len() <= 0) {
+        if (msg->is_raw()) {
+            msg->set_raw_body("", 0);
+        }
         sbuf->skip_bytes(PROTO_MSG_HEAD_LEN);
         return CodecProto::STATUS::OK;
     }
@@ -81,7 +97,14 @@ Codec::STATUS CodecProto::decode(SocketBuffer* sbuf, std::shared_ptr<Msg> msg) {
         return CodecProto::STATUS::PAUSE;
     }
 
-    ret = body->ParseFromArray(sbuf->raw_read_buffer() + PROTO_MSG_HEAD_LEN, head->len());
+    if (msg->is_raw()) {
+        /* pass-through, keep the body undecoded. */
+        msg->set_raw_body(sbuf->raw_read_buffer() + PROTO_MSG_HEAD_LEN, head->len());
+        sbuf->skip_bytes(PROTO_MSG_HEAD_LEN + head->len());
+        return CodecProto::STATUS::OK;
+    }
+
+    ret = msg->body()->ParseFromArray(sbuf->raw_read_buffer() + PROTO_MSG_HEAD_LEN, head->len());
     if (!ret) {
         LOG_ERROR("cmd: %d, seq: %d, parse msg body failed!",
                   head->cmd(), head->seq());
@@ -0,0 +1,121 @@
+#pragma once
+
+#include "connection.h"
+
+namespace kim {
+
+/* fd-indexed connection table.
+ *
+ * conn id: (generation << 32) | fd, the slot's generation increases
+ * every time the fd is reused, so an old fd_t can be validated by
+ * a single array index instead of hash lookups. */
+class ConnSlab {
+   public:
+    typedef struct slot_s {
+        uint32_t gen = 0;
+        std::shared_ptr<Connection> c = nullptr;
+    } slot_t;
+
+    ConnSlab() {}
+    virtual ~ConnSlab() {}
+
+    ConnSlab(const ConnSlab&) = delete;
+    ConnSlab& operator=(const ConnSlab&) = delete;
+
+    static int id_to_fd(uint64_t id) { return (int)(id & 0xffffffff); }
+    static uint32_t id_to_gen(uint64_t id) { return (uint32_t)(id >> 32); }
+
+    /* reserve slots for fds, avoid resizing in running. */
+    void reserve(size_t cnt) {
+        if (cnt > m_slots.size()) {
+            m_slots.resize(cnt);
+        }
+    }
+
+    /* new id for fd, the generation of the fd's slot increases. */
+    uint64_t new_id(int fd) {
+        if (fd < 0) {
+            return 0;
+        }
+        ensure_slot(fd);
+        return ((uint64_t)(++m_slots[fd].gen) << 32) | (uint32_t)fd;
+    }
+
+    /* return the old connection which is using the same fd, if it exists. */
+    std::shared_ptr<Connection> add(std::shared_ptr<Connection> c) {
+        int fd = id_to_fd(c->id());
+        ensure_slot(fd);
+
+        slot_t& s = m_slots[fd];
+        auto old = s.c;
+        if (old == nullptr) {
+            m_cnt++;
+        }
+        s.gen = id_to_gen(c->id());
+        s.c = c;
+        return old;
+    }
+
+    std::shared_ptr<Connection> get(uint64_t id) {
+        size_t fd = (size_t)id_to_fd(id);
+        if (fd >= m_slots.size()) {
+            return nullptr;
+        }
+        slot_t& s = m_slots[fd];
+        return (s.c != nullptr && s.gen == id_to_gen(id)) ? s.c : nullptr;
+    }
+
+    std::shared_ptr<Connection> get_by_fd(int fd) {
+        return (fd >= 0 && (size_t)fd < m_slots.size()) ? m_slots[fd].c : nullptr;
+    }
+
+    bool del(uint64_t id) {
+        size_t fd = (size_t)id_to_fd(id);
+        if (fd >= m_slots.size()) {
+            return false;
+        }
+        slot_t& s = m_slots[fd];
+        if (s.c == nullptr || s.gen != id_to_gen(id)) {
+            return false;
+        }
+        s.c = nullptr;
+        m_cnt--;
+        return true;
+    }
+
+    template <typename F>
+    void for_each(F fn) {
+        for (auto& s : m_slots) {
+            if (s.c != nullptr) {
+                fn(s.c);
+            }
+        }
+    }
+
+    /* keep generations, ids are unique in process's life. */
+    void clear() {
+        for (auto& s : m_slots) {
+            s.c = nullptr;
+        }
+        m_cnt = 0;
+    }
+
+    size_t size() { return m_cnt; }
+
+   private:
+    void ensure_slot(int fd) {
+        if ((size_t)fd >= m_slots.size()) {
+            size_t size = m_slots.empty() ? 1024 : m_slots.size();
+            while (size <= (size_t)fd) {
+                size <<= 1;
+            }
+            m_slots.resize(size);
+        }
+    }
+
+   private:
+    size_t m_cnt = 0;            /* connection count. */
+    std::vector<slot_t> m_slots; /* index: fd. */
+};
+
+}  // namespace kim
@@ -3,7 +3,9 @@
 #include <unistd.h>
 
 #include "codec/codec_http.h"
+#include "codec/codec_private.h"
 #include "codec/codec_proto.h"
+#include "libco/co_routine.h"
 #include "msg.h"
 #include "util/util.h"
 
@@ -16,6 +18,11 @@ Connection::Connection(std::shared_ptr<Log> logger, std::shared_ptr<INet> net, i
 }
 
 Connection::~Connection() {
+    detach_fd_event();
+    for (auto& cond : m_wait_conds) {
+        co_cond_free(cond);
+        cond = nullptr;
+    }
     SAFE_FREE(m_saddr);
     SAFE_DELETE(m_codec);
     SAFE_DELETE(m_recv_buf);
@@ -34,6 +41,10 @@ bool Connection::init(Codec::TYPE codec) {
             m_codec = new CodecProto(m_logger, codec);
             break;
         }
+        case Codec::TYPE::PRIVATE: {
+            m_codec = new CodecPrivate(m_logger, codec);
+            break;
+        }
         default: {
             LOG_ERROR("invalid codec type: %d", (int)codec);
             break;
@@ -66,7 +77,9 @@ Codec::STATUS Connection::conn_read() {
         return Codec::STATUS::ERR;
     }
 
-    int read_len = m_recv_buf->read_fd(fd(), m_errno);
+    size_t read_limit = m_recv_buf->read_fd_limit();
+    int read_len = (m_uring_recv != nullptr) ? read_uring_recv()
+                                             : m_recv_buf->read_fd(fd(), m_errno);
     if (read_len >= 0) {
         LOG_TRACE("read from fd: %d, data len: %d, readed data len: %d",
                   fd(), read_len, m_recv_buf->readable_len());
@@ -77,6 +90,7 @@ Codec::STATUS Connection::conn_read() {
         return Codec::STATUS::CLOSED;
     } else if (read_len < 0) {
         if (errno == EAGAIN) {
+            co_fd_event_clear(m_fd_event, POLLIN);
             return Codec::STATUS::PAUSE;
         } else {
             LOG_DEBUG("connection read error! fd: %d, err: %d, error: %s",
@@ -87,6 +101,11 @@ Codec::STATUS Connection::conn_read() {
         m_read_cnt++;
         m_read_bytes += read_len;
 
+        if (m_uring_recv == nullptr && (size_t)read_len < read_limit) {
+            /* drained, wait for next edge. */
+            co_fd_event_clear(m_fd_event, POLLIN);
+        }
+
         /* recovery socket buffer. */
         if (m_recv_buf->capacity() > SocketBuffer::BUFFER_MAX_READ &&
             m_recv_buf->readable_len() < m_recv_buf->capacity() / 2) {
@@ -98,6 +117,28 @@ Codec::STATUS Connection::conn_read() {
     return Codec::STATUS::OK;
 }
 
+int Connection::read_uring_recv() {
+    /* copy the data which has been received by kernel. */
+    size_t pending = co_uring_recv_pending(m_uring_recv);
+    if (!m_recv_buf->ensure_writeable(pending > 0 ? pending : 1)) {
+        m_errno = errno = ENOMEM;
+        return -1;
+    }
+
+    int read_len = co_uring_recv_read(m_uring_recv, m_recv_buf->raw_write_buffer(),
+                                      m_recv_buf->writeable_len());
+    if (read_len > 0) {
+        m_recv_buf->advance_write_index(read_len);
+    } else if (read_len < 0) {
+        if (errno == ENOBUFS) {
+            /* buffer ring ran out, read the socket this time. */
+            return m_recv_buf->read_fd(fd(), m_errno);
+        }
+        m_errno = errno;
+    }
+    return read_len;
+}
+
 Codec::STATUS Connection::conn_write() {
     if (is_invalid()) {
         LOG_ERROR("conn is invalid, fd: %d, %llu", fd(), id());
@@ -117,6 +158,7 @@ Codec::STATUS Connection::conn_write() {
     write_len = sbuf->write_fd(fd(), m_errno);
     if (write_len < 0) {
         if (m_errno == EAGAIN) {
+            co_fd_event_clear(m_fd_event, POLLOUT);
             return Codec::STATUS::PAUSE;
         } else {
             LOG_DEBUG(
@@ -140,7 +182,95 @@ Codec::STATUS Connection::conn_write() {
     }
 
     m_active_time = now();
-    return (sbuf->readable_len() > 0) ? Codec::STATUS::PAUSE : Codec::STATUS::OK;
+
+    if (sbuf->readable_len() > 0) {
+        /* socket's send buffer is full, wait for next edge. */
+        co_fd_event_clear(m_fd_event, POLLOUT);
+        return Codec::STATUS::PAUSE;
+    }
+    return Codec::STATUS::OK;
+}
+
+bool Connection::attach_fd_event() {
+    if (m_fd_event == nullptr) {
+        m_fd_event = co_fd_event_alloc(fd());
+        if (m_fd_event == nullptr) {
+            LOG_WARN("attach fd event failed! fd: %d, errno: %d", fd(), errno);
+            return false;
+        }
+    }
+    return true;
+}
+
+void Connection::detach_fd_event() {
+    if (m_fd_event != nullptr) {
+        co_fd_event_free(m_fd_event);
+        m_fd_event = nullptr;
+        /* the queued waiters find the event gone. */
+        for (auto cond : m_wait_conds) {
+            if (cond != nullptr) {
+                co_cond_broadcast(cond);
+            }
+        }
+    }
+    if (m_uring_recv != nullptr) {
+        co_uring_recv_free(m_uring_recv);
+        m_uring_recv = nullptr;
+    }
+}
+
+bool Connection::attach_uring_recv() {
+    if (m_uring_recv == nullptr) {
+        m_uring_recv = co_uring_recv_alloc(fd());
+        if (m_uring_recv == nullptr) {
+            LOG_WARN("attach uring recv failed! fd: %d, errno: %d", fd(), errno);
+            return false;
+        }
+    }
+    return true;
+}
+
+int Connection::wait_event(int events, int ms) {
+    if (m_uring_recv != nullptr && events == POLLIN) {
+        /* -1: recv failed, let the reader get the error. */
+        return (co_uring_recv_wait(m_uring_recv, ms) != 0) ? POLLIN : 0;
+    }
+
+    if (m_fd_event == nullptr) {
+        return co_sleep(ms, fd(), events);
+    }
+
+    /* only one coroutine waits on a direction of the fd event, the others queue
+     * behind it, and wait on the event again when it is woken up. */
+    auto& cond = m_wait_conds[(events & POLLOUT) ? 1 : 0];
+    unsigned long long deadline = co_tick_ms_precise() + ms;
+
+    for (;;) {
+        int ret = co_fd_event_wait(m_fd_event, events, ms);
+        if (ret >= 0 || errno != EBUSY) {
+            if (cond != nullptr) {
+                co_cond_broadcast(cond);
+            }
+            return ret;
+        }
+
+        if (cond == nullptr) {
+            cond = co_cond_alloc();
+        }
+        co_cond_timedwait(cond, ms);
+
+        if (m_fd_event == nullptr) {
+            errno = EBADF;
+            return -1;
+        }
+        if (ms > 0) {
+            auto now = co_tick_ms_precise();
+            if (now >= deadline) {
+                return 0;
+            }
+            ms = (int)(deadline - now);
+        }
+    }
 }
 
 Codec::STATUS Connection::conn_read(std::shared_ptr<Msg> msg) {
@@ -171,12 +301,12 @@ Codec::STATUS Connection::fetch_data(std::shared_ptr<Msg> msg) {
 }
 
 Codec::STATUS Connection::decode_proto(std::shared_ptr<Msg> msg) {
-    CodecProto* codec = dynamic_cast<CodecProto*>(m_codec);
-    if (codec == nullptr) {
+    if (m_codec == nullptr || is_http()) {
         return Codec::STATUS::ERR;
     }
 
-    return codec->decode(m_recv_buf, msg);
+    /* protobuf or private codec. */
+    return m_codec->decode(m_recv_buf, msg);
 }
 
 Codec::STATUS Connection::conn_append_message(std::shared_ptr<Msg> msg) {
@@ -185,8 +315,7 @@ Codec::STATUS Connection::conn_append_message(std::shared_ptr<Msg> msg) {
         return Codec::STATUS::ERR;
     }
 
-    auto codec = dynamic_cast<CodecProto*>(m_codec);
-    if (codec == nullptr) {
+    if (m_codec == nullptr || is_http()) {
         return Codec::STATUS::ERR;
     }
 
@@ -195,7 +324,7 @@ Codec::STATUS Connection::conn_append_message(std::shared_ptr<Msg> msg) {
         return Codec::STATUS::ERR;
     }
 
-    auto status = codec->encode(msg, m_send_buf);
+    auto status = m_codec->encode(msg, m_send_buf);
     if (status != Codec::STATUS::OK) {
         LOG_ERROR("encode packed failed! fd: %d, seq: %llu, status: %d",
                   fd(), id(), (int)status);
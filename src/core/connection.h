@@ -6,6 +6,9 @@
 #include "util/log.h"
 #include "util/socket_buffer.h"
 
+struct stCoFdEvent_t;
+struct stCoUringRecv_t;
+
 namespace kim {
 
 class Connection : public Logger, public Net {
@@ -35,7 +38,7 @@ class Connection : public Logger, public Net {
 
     void set_privdata(void* data) { m_privdata = data; }
     void* privdata() const { return m_privdata; }
-    int64_t now() { return (net() != nullptr) ? net()->now() : mstime(); }
+    int64_t now() { return (net() != nullptr) ? net()->now() : co_tick_ms(); }
 
     void set_state(STATE state) { m_state = state; }
     STATE state() const { return m_state; }
@@ -58,6 +61,18 @@ class Connection : public Logger, public Net {
     bool is_system() { return m_is_system; }
     void set_system(bool is_sys) { m_is_system = is_sys; }
 
+    bool is_client() { return m_is_client; }
+    void set_client(bool on) { m_is_client = on; }
+
+    /* gate relays the conn's msgs to other nodes without decoding their body. */
+    bool is_pass_through() { return m_is_pass_through; }
+    void set_pass_through(bool on) { m_is_pass_through = on; }
+
+    /* cork: data in send buffer waits to be flushed at the end of the event loop's tick. */
+    bool is_dirty() { return m_is_dirty; }
+    void set_dirty(bool on) { m_is_dirty = on; }
+    bool has_send_data() { return m_send_buf != nullptr && m_send_buf->readable_len() > 0; }
+
     Codec::STATUS conn_read(HttpMsg& msg);
     Codec::STATUS conn_write(const HttpMsg& msg);
     Codec::STATUS fetch_data(HttpMsg& msg);
@@ -70,6 +85,15 @@ class Connection : public Logger, public Net {
 
     virtual bool is_need_alive_check();
 
+    /* fd stays in libco's epoll (edge-triggered) until detach. */
+    bool attach_fd_event();
+    void detach_fd_event(); /* releases io_uring's recv too. */
+    bool is_edge_trigger() { return m_fd_event != nullptr; }
+    /* io_uring engine: multishot recv keeps reading into libco's buffer ring. */
+    bool attach_uring_recv();
+    /* wait for events (POLLIN/POLLOUT), return poll's revents, 0: timeout. */
+    int wait_event(int events, int ms);
+
     /* statistics api. */
     int write_cnt() { return m_write_cnt; }
     uint64_t write_bytes() { return m_write_bytes; }
@@ -83,6 +107,7 @@ class Connection : public Logger, public Net {
 
    private:
     Codec::STATUS conn_read();
+    int read_uring_recv();
     Codec::STATUS decode_http(HttpMsg& msg);
     Codec::STATUS decode_proto(std::shared_ptr<Msg> msg);
     Codec::STATUS conn_write(const HttpMsg& msg, SocketBuffer** buf);
@@ -92,12 +117,19 @@ class Connection : public Logger, public Net {
     void* m_privdata = nullptr; /* private data. */
     Codec* m_codec = nullptr;   /* protocol parser。 */
     bool m_is_system = false;   /* system connection. */
+    bool m_is_client = false;       /* conn of gate's client. */
+    bool m_is_pass_through = false; /* msgs keep undecoded body. */
+    bool m_is_dirty = false;        /* cork, waiting for flush. */
 
     int m_errno = 0;               /* error number. */
     STATE m_state = STATE::UNKOWN; /* connection status. */
 
     SocketBuffer* m_recv_buf = nullptr;
     SocketBuffer* m_send_buf = nullptr;
+    stCoFdEvent_t* m_fd_event = nullptr;     /* persistent epoll registration. */
+    stCoUringRecv_t* m_uring_recv = nullptr; /* io_uring multishot recv. */
+    /* coroutines queued behind the one waiting on m_fd_event, 0: POLLIN, 1: POLLOUT. */
+    stCoCond_t* m_wait_conds[2] = {nullptr, nullptr};
 
     size_t m_saddr_len = 0;
     struct sockaddr* m_saddr = nullptr;
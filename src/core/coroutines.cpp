@@ -41,8 +41,11 @@ void Coroutines::exit_libco() {
     m_is_exit = true;
 }
 
-void Coroutines::run() {
-    co_eventloop(co_get_epoll_ct(), [this](void*) {
+void Coroutines::run(std::function<void()> on_tick) {
+    co_eventloop(co_get_epoll_ct(), [this, on_tick](void*) {
+        if (on_tick != nullptr) {
+            on_tick();
+        }
         return m_is_exit ? -1 : 0;
     });
 }
@@ -50,18 +53,17 @@ void Coroutines::run() {
 stCoRoutine_t* Coroutines::start_co(pfn_co_routine_t fn) {
     if (fn == nullptr) {
         LOG_ERROR("invalid param!");
-        return false;
+        return nullptr;
     }
 
     if ((int)m_work_coroutines.size() > m_max_co_cnt) {
         LOG_ERROR("exceed the coroutines's limit: %d", m_max_co_cnt);
-        return false;
+        return nullptr;
     }
 
     stCoRoutine_t* co = nullptr;
     if (m_free_coroutines.empty()) {
         co_create(&co, &m_co_attr, fn);
-        m_work_coroutines.insert(co);
     } else {
         co = m_free_coroutines.front();
         m_free_coroutines.pop();
@@ -69,6 +71,8 @@ stCoRoutine_t* Coroutines::start_co(pfn_co_routine_t fn) {
         co->pfn = fn;
         LOG_TRACE("reuse free co: %p", co);
     }
+    /* a reused one works again, it's counted and can be freed again. */
+    m_work_coroutines.insert(co);
     co->arg = co;
     co_resume(co);
     return co;
@@ -105,6 +109,13 @@ void Coroutines::on_repeat_timer() {
             LOG_INFO("free co cnt: %u", m_free_coroutines.size());
         }
     }
+
+    run_with_period(60 * 1000) {
+        stCoStackStat_t stat;
+        co_get_stack_stat(&stat);
+        LOG_DEBUG("share stack, save cnt: %llu, save bytes: %llu, max save size: %u",
+                  stat.save_cnt, stat.save_bytes, stat.max_save_size);
+    }
 }
 
 }  // namespace kim
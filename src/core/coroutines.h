@@ -17,12 +17,13 @@ class Coroutines : public Logger, public TimerCron {
 
     void destroy();
 
-    void run();
+    void run(std::function<void()> on_tick = nullptr); /* on_tick: called once per event loop. */
     void exit_libco();
     void set_max_co_cnt(int cnt) { m_max_co_cnt = cnt; }
 
     bool add_free_co(stCoRoutine_t* co);
     stCoRoutine_t* start_co(pfn_co_routine_t fn);
+    size_t work_co_cnt() { return m_work_coroutines.size(); }
     virtual void on_repeat_timer() override;
 
    private:
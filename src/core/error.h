@@ -38,6 +38,8 @@ enum E_ERROR {
     ERR_REDIS_TASKS_CLEAR = 11007,
     ERR_REDIS_APPEND_CMD_FAILED = 11008,
     ERR_REDIS_GET_REPLY_FAILED = 11009,
+    ERR_REDIS_CLUSTER_REDIRECT = 11010, /* MOVED/ASK, redirected inside RedisMgr. */
+    ERR_REDIS_CLUSTER_REDIRECT_FAILED = 11011,
 
     // database.
     ERR_DB_FAILED = 12001,
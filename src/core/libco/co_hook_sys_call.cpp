@@ -46,6 +46,7 @@
 typedef long long ll64_t;
 
 struct rpchook_t {
+    int used;  // the fd is hooked.
     int user_flag;
     struct sockaddr_in dest;  //maybe sockaddr_un;
     int domain;               //AF_LOCAL , AF_INET
@@ -59,7 +60,20 @@ static inline pid_t GetPid() {
     return p ? *(pid_t *)(p + 18) : getpid();
 }
 
-static rpchook_t *g_rpchook_socket_fd[102400] = {0};
+// hooked fds' table, fd -> rpchook_t, entries are embedded in chunks,
+// a chunk is allocated when an fd in its range is hooked at the first time,
+// then it is kept for the process's life, so lookups need no lock.
+// 16384 chunks * 1024 entries, fds up to 16M are supported.
+struct stRpcHookChunk_t {
+    enum {
+        _CHUNK_BITS = 10,
+        _CHUNK_SIZE = 1 << _CHUNK_BITS,
+        _CHUNK_CNT = 16 * 1024,
+    };
+    rpchook_t entries[_CHUNK_SIZE];
+};
+
+static stRpcHookChunk_t *g_rpchook_socket_fd[stRpcHookChunk_t::_CHUNK_CNT] = {0};
 
 typedef int (*socket_pfn_t)(int domain, int type, int protocol);
 typedef int (*connect_pfn_t)(int socket, const struct sockaddr *address, socklen_t address_len);
@@ -172,31 +186,60 @@ static inline ll64_t diff_ms(struct timeval &begin, struct timeval &end) {
     return u;
 }
 
+// io_uring engine can not take the op (no sqe, buffer ring exhausted), use poll.
+static inline bool is_uring_fallback(ssize_t ret) {
+    return ret < 0 && (errno == ENOSYS || errno == ENOBUFS);
+}
+
+static inline stRpcHookChunk_t *get_chunk(int fd, bool alloc) {
+    if (fd < 0 || (fd >> stRpcHookChunk_t::_CHUNK_BITS) >= stRpcHookChunk_t::_CHUNK_CNT) {
+        return NULL;
+    }
+    stRpcHookChunk_t **pp = &g_rpchook_socket_fd[fd >> stRpcHookChunk_t::_CHUNK_BITS];
+    stRpcHookChunk_t *chunk = __atomic_load_n(pp, __ATOMIC_ACQUIRE);
+    if (chunk || !alloc) {
+        return chunk;
+    }
+
+    // threads may hook fds in the same range at the same time, only one chunk wins.
+    chunk = (stRpcHookChunk_t *)calloc(1, sizeof(stRpcHookChunk_t));
+    if (!chunk) {
+        return NULL;
+    }
+    stRpcHookChunk_t *expected = NULL;
+    if (!__atomic_compare_exchange_n(pp, &expected, chunk, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        free(chunk);
+        chunk = expected;
+    }
+    return chunk;
+}
+
 static inline rpchook_t *get_by_fd(int fd) {
-    if (fd > -1 && fd < (int)sizeof(g_rpchook_socket_fd) / (int)sizeof(g_rpchook_socket_fd[0])) {
-        return g_rpchook_socket_fd[fd];
+    stRpcHookChunk_t *chunk = get_chunk(fd, false);
+    if (chunk) {
+        rpchook_t *lp = &chunk->entries[fd & (stRpcHookChunk_t::_CHUNK_SIZE - 1)];
+        return lp->used ? lp : NULL;
     }
     return NULL;
 }
 
 static inline rpchook_t *alloc_by_fd(int fd) {
-    if (fd > -1 && fd < (int)sizeof(g_rpchook_socket_fd) / (int)sizeof(g_rpchook_socket_fd[0])) {
-        rpchook_t *lp = (rpchook_t *)calloc(1, sizeof(rpchook_t));
+    stRpcHookChunk_t *chunk = get_chunk(fd, true);
+    if (chunk) {
+        rpchook_t *lp = &chunk->entries[fd & (stRpcHookChunk_t::_CHUNK_SIZE - 1)];
+        memset(lp, 0, sizeof(rpchook_t));
         lp->read_timeout.tv_sec = 1;
         lp->write_timeout.tv_sec = 1;
-        g_rpchook_socket_fd[fd] = lp;
+        lp->used = 1;
         return lp;
     }
     return NULL;
 }
 
 static inline void free_by_fd(int fd) {
-    if (fd > -1 && fd < (int)sizeof(g_rpchook_socket_fd) / (int)sizeof(g_rpchook_socket_fd[0])) {
-        rpchook_t *lp = g_rpchook_socket_fd[fd];
-        if (lp) {
-            g_rpchook_socket_fd[fd] = NULL;
-            free(lp);
-        }
+    stRpcHookChunk_t *chunk = get_chunk(fd, false);
+    if (chunk) {
+        chunk->entries[fd & (stRpcHookChunk_t::_CHUNK_SIZE - 1)].used = 0;
     }
     return;
 }
@@ -213,7 +256,9 @@ int socket(int domain, int type, int protocol) {
     }
 
     rpchook_t *lp = alloc_by_fd(fd);
-    lp->domain = domain;
+    if (lp) {
+        lp->domain = domain;
+    }
 
     fcntl(fd, F_SETFL, g_sys_fcntl_func(fd, F_GETFL, 0));
 
@@ -318,6 +363,13 @@ ssize_t read(int fd, void *buf, size_t nbyte) {
     }
     int timeout = (lp->read_timeout.tv_sec * 1000) + (lp->read_timeout.tv_usec / 1000);
 
+    if (co_get_io_engine() == CO_IO_ENGINE_URING) {
+        ssize_t ret = co_uring_recv(fd, buf, nbyte, 0, timeout);
+        if (!is_uring_fallback(ret)) {
+            return ret;
+        }
+    }
+
     struct pollfd pf = {0};
     pf.fd = fd;
     pf.events = (POLLIN | POLLERR | POLLHUP);
@@ -350,6 +402,13 @@ ssize_t write(int fd, const void *buf, size_t nbyte) {
     size_t wrotelen = 0;
     int timeout = (lp->write_timeout.tv_sec * 1000) + (lp->write_timeout.tv_usec / 1000);
 
+    if (co_get_io_engine() == CO_IO_ENGINE_URING) {
+        ssize_t ret = co_uring_send(fd, buf, nbyte, 0, timeout);
+        if (!is_uring_fallback(ret)) {
+            return ret;
+        }
+    }
+
     ssize_t writeret = g_sys_write_func(fd, (const char *)buf + wrotelen, nbyte - wrotelen);
 
     if (writeret == 0) {
@@ -452,6 +511,13 @@ ssize_t send(int socket, const void *buffer, size_t length, int flags) {
     size_t wrotelen = 0;
     int timeout = (lp->write_timeout.tv_sec * 1000) + (lp->write_timeout.tv_usec / 1000);
 
+    if (co_get_io_engine() == CO_IO_ENGINE_URING) {
+        ssize_t ret = co_uring_send(socket, buffer, length, flags, timeout);
+        if (!is_uring_fallback(ret)) {
+            return ret;
+        }
+    }
+
     ssize_t writeret = g_sys_send_func(socket, buffer, length, flags);
     if (writeret == 0) {
         return writeret;
@@ -492,6 +558,13 @@ ssize_t recv(int socket, void *buffer, size_t length, int flags) {
     }
     int timeout = (lp->read_timeout.tv_sec * 1000) + (lp->read_timeout.tv_usec / 1000);
 
+    if (co_get_io_engine() == CO_IO_ENGINE_URING) {
+        ssize_t ret = co_uring_recv(socket, buffer, length, flags, timeout);
+        if (!is_uring_fallback(ret)) {
+            return ret;
+        }
+    }
+
     struct pollfd pf = {0};
     pf.fd = socket;
     pf.events = (POLLIN | POLLERR | POLLHUP);
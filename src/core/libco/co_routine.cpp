@@ -31,6 +31,10 @@
 #include <sys/socket.h>
 #include <sys/syscall.h>
 #include <sys/time.h>
+#include <time.h>
+#if !defined(__APPLE__) && !defined(__FreeBSD__)
+#include <sys/eventfd.h>
+#endif
 #include <unistd.h>
 
 #include <map>
@@ -38,6 +42,7 @@
 
 #include "co_epoll.h"
 #include "co_routine_inner.h"
+#include "co_uring.h"
 
 extern "C" {
 extern void coctx_swap(coctx_t *, coctx_t *) asm("coctx_swap");
@@ -55,6 +60,8 @@ struct stCoRoutineEnv_t {
     // for copy stack log lastco and nextco
     stCoRoutine_t *pending_co;
     stCoRoutine_t *occupy_co;
+
+    stCoStackStat_t stStackStat;
 };
 
 // int socket(int domain, int type, int protocol);
@@ -93,20 +100,69 @@ static unsigned long long getCpuKhz() {
 }
 #endif
 
-static unsigned long long GetTickMS() {
+// loop clock, milliseconds of the monotonic clock, refreshed once per
+// co_eventloop iteration, so timeouts and callers in the same iteration
+// read the same time without calling the clock again and again.
+static __thread unsigned long long gTickMS = 0;
+
+#if defined(CLOCK_MONOTONIC_COARSE)
+static clockid_t GetCoarseClock() {
+    // the coarse clock is read without the tsc, but it only ticks per jiffy,
+    // fall back to the precise one if it can not keep timeouts in milliseconds.
+    struct timespec res = {0};
+    if (clock_getres(CLOCK_MONOTONIC_COARSE, &res) == 0 &&
+        res.tv_sec == 0 && res.tv_nsec <= 1000 * 1000) {
+        return CLOCK_MONOTONIC_COARSE;
+    }
+    return CLOCK_MONOTONIC;
+}
+#endif
+
+static unsigned long long ReadClockMS(bool bCoarse) {
 #if defined(__LIBCO_RDTSCP__)
     static uint32_t khz = getCpuKhz();
     return counter() / khz;
 #else
-    struct timeval now = {0};
-    gettimeofday(&now, NULL);
+    clockid_t id = CLOCK_MONOTONIC;
+#if defined(CLOCK_MONOTONIC_COARSE)
+    static clockid_t coarse = GetCoarseClock();
+    if (bCoarse) {
+        id = coarse;
+    }
+#endif
+    struct timespec now = {0};
+    clock_gettime(id, &now);
     unsigned long long u = now.tv_sec;
     u *= 1000;
-    u += now.tv_usec / 1000;
+    u += now.tv_nsec / 1000000;
     return u;
 #endif
 }
 
+static unsigned long long UpdateTickMS(bool bCoarse) {
+    // the coarse clock may lag behind the precise one, never go back.
+    unsigned long long u = ReadClockMS(bCoarse);
+    if (u > gTickMS) {
+        gTickMS = u;
+    }
+    return gTickMS;
+}
+
+// the loop clock may be stale by the time which the handlers have taken
+// in this iteration, timeouts are registered with a ticked clock instead,
+// otherwise they would be raised earlier than asked.
+static unsigned long long GetTickMS() {
+    return gTickMS ? gTickMS : UpdateTickMS(false);
+}
+
+unsigned long long co_tick_ms() {
+    return GetTickMS();
+}
+
+unsigned long long co_tick_ms_precise() {
+    return UpdateTickMS(false);
+}
+
 /* no longer use
 static pid_t GetPid()
 {
@@ -282,13 +338,24 @@ static stStackMem_t *co_get_stackmem(stShareStack_t *share_stack) {
 // ----------------------------------------------------------------------------
 struct stTimeoutItemLink_t;
 struct stTimeoutItem_t;
+struct stCoUring_t;
+struct stCoUringOp_t;
 struct stCoEpoll_t {
     int iEpollFd;
     static const int _EPOLL_SIZE = 1024 * 10;
+    static const int _MAX_WAIT_MS = 1000;  // the loop's pfn is called at least once a second.
     struct stTimeout_t *pTimeout;
     struct stTimeoutItemLink_t *pstTimeoutList;
     struct stTimeoutItemLink_t *pstActiveList;
     co_epoll_res *result;
+
+    int iWakeupFd[2];                       // eventfd (pipe on bsd), wakes up the waiting loop.
+    struct stTimeoutItem_t *pWakeupItem;  // wakeup fd's epoll item.
+
+    // io_uring engine, NULL: epoll.
+    struct stCoUring_t *pUring;
+    struct stCoUringOp_t *pEpollOp;  // multishot poll on iEpollFd.
+    int iEpollPending;               // epoll fd may have events to fetch.
 };
 
 typedef void (*OnPreparePfn_t)(stTimeoutItem_t *, struct epoll_event &ev, stTimeoutItemLink_t *active);
@@ -316,33 +383,62 @@ struct stTimeoutItemLink_t {
     stTimeoutItem_t *tail;
 };
 
+// hierarchical timing wheel, 1ms per tick, every level has 64 slots,
+// level n covers 64^(n+1) ms, 6 levels cover 2^36 ms (~795 days), the
+// later expiries wait in the last level and are cascaded again.
+// items in a higher level slot are cascaded into lower levels when the
+// wheel turns to the slot. bitmaps mark the slots which may have items,
+// so empty slots and levels are skipped.
+enum {
+    eTimeoutLevelBits = 6,
+    eTimeoutLevelSlots = 1 << eTimeoutLevelBits,
+    eTimeoutSlotMask = eTimeoutLevelSlots - 1,
+    eTimeoutLevelCnt = 6,
+};
+
 struct stTimeout_t {
-    stTimeoutItemLink_t *pItems;
-    int iItemSize;
+    stTimeoutItemLink_t pItems[eTimeoutLevelCnt][eTimeoutLevelSlots];
+    unsigned long long ullBitmap[eTimeoutLevelCnt];  // slot may be not empty.
 
-    unsigned long long ullStart;
-    long long llStartIdx;
+    unsigned long long ullStart;  // current tick, items due in it have been taken.
 };
 
-stTimeout_t *AllocTimeout(int iSize) {
+stTimeout_t *AllocTimeout() {
     stTimeout_t *lp = (stTimeout_t *)calloc(1, sizeof(stTimeout_t));
-    lp->iItemSize = iSize;
-    lp->pItems = (stTimeoutItemLink_t *)calloc(1, sizeof(stTimeoutItemLink_t) * lp->iItemSize);
     lp->ullStart = GetTickMS();
-    lp->llStartIdx = 0;
     return lp;
 }
 
 void FreeTimeout(stTimeout_t *apTimeout) {
-    free(apTimeout->pItems);
     free(apTimeout);
 }
 
-int AddTimeout(stTimeout_t *apTimeout, stTimeoutItem_t *apItem, unsigned long long allNow) {
-    if (apTimeout->ullStart == 0) {
-        apTimeout->ullStart = allNow;
-        apTimeout->llStartIdx = 0;
+// bCurTaken: the current tick's slot has been taken, the items due in it
+// are linked to the next tick. cascading runs before the slot is taken.
+static void LinkTimeout(stTimeout_t *apTimeout, stTimeoutItem_t *apItem, bool bCurTaken) {
+    unsigned long long expire = apItem->ullExpireTime;
+    if (expire < apTimeout->ullStart || (bCurTaken && expire == apTimeout->ullStart)) {
+        expire = bCurTaken ? apTimeout->ullStart + 1 : apTimeout->ullStart;
+    }
+
+    unsigned long long diff = expire - apTimeout->ullStart;
+    const unsigned long long ullMaxDiff = (1ULL << (eTimeoutLevelBits * eTimeoutLevelCnt)) - 1;
+    if (diff > ullMaxDiff) {
+        diff = ullMaxDiff;
+        expire = apTimeout->ullStart + diff;
+    }
+
+    int level = 0;
+    while (level < eTimeoutLevelCnt - 1 && diff >= (1ULL << (eTimeoutLevelBits * (level + 1)))) {
+        level++;
     }
+
+    int idx = (expire >> (eTimeoutLevelBits * level)) & eTimeoutSlotMask;
+    AddTail(&apTimeout->pItems[level][idx], apItem);
+    apTimeout->ullBitmap[level] |= (1ULL << idx);
+}
+
+int AddTimeout(stTimeout_t *apTimeout, stTimeoutItem_t *apItem, unsigned long long allNow) {
     if (allNow < apTimeout->ullStart) {
         co_log_err("CO_ERR: AddTimeout line %d allNow %llu apTimeout->ullStart %llu",
                    __LINE__, allNow, apTimeout->ullStart);
@@ -355,42 +451,86 @@ int AddTimeout(stTimeout_t *apTimeout, stTimeoutItem_t *apItem, unsigned long lo
 
         return __LINE__;
     }
-    unsigned long long diff = apItem->ullExpireTime - apTimeout->ullStart;
 
-    if (diff >= (unsigned long long)apTimeout->iItemSize) {
-        diff = apTimeout->iItemSize - 1;
-        co_log_err("CO_ERR: AddTimeout line %d diff %d",
-                   __LINE__, diff);
+    LinkTimeout(apTimeout, apItem, true);
+    return 0;
+}
 
-        // return __LINE__;
+static void CascadeTimeout(stTimeout_t *apTimeout, int level) {
+    int idx = (apTimeout->ullStart >> (eTimeoutLevelBits * level)) & eTimeoutSlotMask;
+    if (!(apTimeout->ullBitmap[level] & (1ULL << idx))) {
+        return;
     }
-    AddTail(apTimeout->pItems + (apTimeout->llStartIdx + diff) % apTimeout->iItemSize, apItem);
+    apTimeout->ullBitmap[level] &= ~(1ULL << idx);
 
-    return 0;
+    stTimeoutItemLink_t items = {NULL, NULL};
+    Join<stTimeoutItem_t, stTimeoutItemLink_t>(&items, &apTimeout->pItems[level][idx]);
+
+    while (items.head) {
+        stTimeoutItem_t *lp = items.head;
+        PopHead<stTimeoutItem_t, stTimeoutItemLink_t>(&items);
+        LinkTimeout(apTimeout, lp, false);
+    }
 }
 
 inline void TakeAllTimeout(stTimeout_t *apTimeout, unsigned long long allNow, stTimeoutItemLink_t *apResult) {
-    if (apTimeout->ullStart == 0) {
-        apTimeout->ullStart = allNow;
-        apTimeout->llStartIdx = 0;
-    }
+    while (apTimeout->ullStart < allNow) {
+        // skip the empty levels, turn to the tick before the next cascade.
+        for (int level = 0; level < eTimeoutLevelCnt && !apTimeout->ullBitmap[level]; level++) {
+            unsigned long long mask = (1ULL << (eTimeoutLevelBits * (level + 1))) - 1;
+            unsigned long long next = (apTimeout->ullStart | mask) + 1;
+            if (next > allNow) {
+                apTimeout->ullStart = allNow;
+                return;
+            }
+            apTimeout->ullStart = next - 1;
+        }
 
-    if (allNow < apTimeout->ullStart) {
-        return;
-    }
-    int cnt = allNow - apTimeout->ullStart + 1;
-    if (cnt > apTimeout->iItemSize) {
-        cnt = apTimeout->iItemSize;
+        apTimeout->ullStart++;
+
+        int idx = apTimeout->ullStart & eTimeoutSlotMask;
+        for (int level = 1; level < eTimeoutLevelCnt && idx == 0; level++) {
+            CascadeTimeout(apTimeout, level);
+            idx = (apTimeout->ullStart >> (eTimeoutLevelBits * level)) & eTimeoutSlotMask;
+        }
+
+        idx = apTimeout->ullStart & eTimeoutSlotMask;
+        if (apTimeout->ullBitmap[0] & (1ULL << idx)) {
+            apTimeout->ullBitmap[0] &= ~(1ULL << idx);
+            Join<stTimeoutItem_t, stTimeoutItemLink_t>(apResult, &apTimeout->pItems[0][idx]);
+        }
     }
-    if (cnt < 0) {
-        return;
+}
+
+// ms to the earliest tick which has to be handled, a level 0 slot is due
+// or a higher level slot has to be cascaded, iMaxMs if the wheel is empty.
+static int NextTimeout(stTimeout_t *apTimeout, unsigned long long allNow, int iMaxMs) {
+    unsigned long long next = ULLONG_MAX;
+
+    for (int level = 0; level < eTimeoutLevelCnt; level++) {
+        unsigned long long bitmap = apTimeout->ullBitmap[level];
+        if (!bitmap) {
+            continue;
+        }
+
+        // rotate the bitmap, bit 0 is the slot after the current one.
+        int shift = eTimeoutLevelBits * level;
+        unsigned long long cur = apTimeout->ullStart >> shift;
+        int idx = (cur + 1) & eTimeoutSlotMask;
+        if (idx) {
+            bitmap = (bitmap >> idx) | (bitmap << (eTimeoutLevelSlots - idx));
+        }
+
+        unsigned long long tick = (cur + 1 + __builtin_ctzll(bitmap)) << shift;
+        if (tick < next) {
+            next = tick;
+        }
     }
-    for (int i = 0; i < cnt; i++) {
-        int idx = (apTimeout->llStartIdx + i) % apTimeout->iItemSize;
-        Join<stTimeoutItem_t, stTimeoutItemLink_t>(apResult, apTimeout->pItems + idx);
+
+    if (next <= allNow) {
+        return 0;
     }
-    apTimeout->ullStart = allNow;
-    apTimeout->llStartIdx += cnt - 1;
+    return (next - allNow < (unsigned long long)iMaxMs) ? (int)(next - allNow) : iMaxMs;
 }
 
 static int CoRoutineFunc(stCoRoutine_t *co, void *) {
@@ -568,6 +708,22 @@ void save_stack_buffer(stCoRoutine_t *occupy_co) {
     occupy_co->save_buffer = (char *)malloc(len);
     occupy_co->save_size = len;
     memcpy(occupy_co->save_buffer, occupy_co->stack_sp, len);
+
+    stCoStackStat_t *stat = &occupy_co->env->stStackStat;
+    stat->save_cnt++;
+    stat->save_bytes += len;
+    if ((unsigned int)len > stat->max_save_size) {
+        stat->max_save_size = len;
+    }
+}
+
+void co_get_stack_stat(stCoStackStat_t *stat) {
+    stCoRoutineEnv_t *env = co_get_curr_thread_env();
+    if (env == NULL) {
+        memset(stat, 0, sizeof(*stat));
+        return;
+    }
+    *stat = env->stStackStat;
 }
 
 void co_swap(stCoRoutine_t *curr, stCoRoutine_t *pending_co) {
@@ -708,6 +864,8 @@ void OnPollPreparePfn(stTimeoutItem_t *ap, struct epoll_event &e, stTimeoutItemL
     }
 }
 
+static int UringWait(stCoEpoll_t *ctx, co_epoll_res *result, int timeout);
+
 void co_eventloop(stCoEpoll_t *ctx, pfn_co_eventloop_t pfn, void *arg) {
     if (!ctx->result) {
         ctx->result = co_epoll_res_alloc(stCoEpoll_t::_EPOLL_SIZE);
@@ -715,7 +873,18 @@ void co_eventloop(stCoEpoll_t *ctx, pfn_co_eventloop_t pfn, void *arg) {
     co_epoll_res *result = ctx->result;
 
     for (;;) {
-        int ret = co_epoll_wait(ctx->iEpollFd, result, stCoEpoll_t::_EPOLL_SIZE, 1);
+        // sleep until the earliest timeout, pfn may add items to the active
+        // list or call co_eventloop_wakeup to run the loop again at once.
+        // the clock is read again before sleeping, or the sleep would be
+        // stretched by the time which the last iteration's handlers took.
+        int wait = (ctx->pstActiveList->head)
+                       ? 0
+                       : NextTimeout(ctx->pTimeout, UpdateTickMS(true), stCoEpoll_t::_MAX_WAIT_MS);
+
+        // io_uring: completions are added to the active list directly.
+        int ret = (ctx->pUring != NULL)
+                      ? UringWait(ctx, result, wait)
+                      : co_epoll_wait(ctx->iEpollFd, result, stCoEpoll_t::_EPOLL_SIZE, wait);
 
         stTimeoutItemLink_t *active = (ctx->pstActiveList);
         stTimeoutItemLink_t *timeout = (ctx->pstTimeoutList);
@@ -731,7 +900,8 @@ void co_eventloop(stCoEpoll_t *ctx, pfn_co_eventloop_t pfn, void *arg) {
             }
         }
 
-        unsigned long long now = GetTickMS();
+        // tick the loop clock once per iteration.
+        unsigned long long now = UpdateTickMS(true);
         TakeAllTimeout(ctx->pTimeout, now, timeout);
 
         stTimeoutItem_t *lp = timeout->head;
@@ -773,20 +943,83 @@ void OnCoroutineEvent(stTimeoutItem_t *ap) {
     co_resume(co);
 }
 
+static void AllocUring(stCoEpoll_t *ctx);
+static void FreeUring(stCoEpoll_t *ctx);
+
+static void OnWakeupEvent(stTimeoutItem_t *ap, struct epoll_event &, stTimeoutItemLink_t *) {
+    stCoEpoll_t *ctx = (stCoEpoll_t *)ap->pArg;
+    char buf[64];
+    while (read(ctx->iWakeupFd[0], buf, sizeof(buf)) > 0) {
+    }
+}
+
+static void AllocWakeup(stCoEpoll_t *ctx) {
+    ctx->iWakeupFd[0] = ctx->iWakeupFd[1] = -1;
+#if !defined(__APPLE__) && !defined(__FreeBSD__)
+    ctx->iWakeupFd[0] = ctx->iWakeupFd[1] = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (ctx->iWakeupFd[0] < 0) {
+        return;
+    }
+#else
+    if (pipe(ctx->iWakeupFd) < 0) {
+        ctx->iWakeupFd[0] = ctx->iWakeupFd[1] = -1;
+        return;
+    }
+    for (int i = 0; i < 2; i++) {
+        fcntl(ctx->iWakeupFd[i], F_SETFL, fcntl(ctx->iWakeupFd[i], F_GETFL) | O_NONBLOCK);
+        fcntl(ctx->iWakeupFd[i], F_SETFD, FD_CLOEXEC);
+    }
+#endif
+
+    ctx->pWakeupItem = (stTimeoutItem_t *)calloc(1, sizeof(stTimeoutItem_t));
+    ctx->pWakeupItem->pfnPrepare = OnWakeupEvent;
+    ctx->pWakeupItem->pArg = ctx;
+
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.ptr = ctx->pWakeupItem;
+    co_epoll_ctl(ctx->iEpollFd, EPOLL_CTL_ADD, ctx->iWakeupFd[0], &ev);
+}
+
+static void FreeWakeup(stCoEpoll_t *ctx) {
+    if (ctx->iWakeupFd[0] >= 0) {
+        close(ctx->iWakeupFd[0]);
+    }
+    if (ctx->iWakeupFd[1] >= 0 && ctx->iWakeupFd[1] != ctx->iWakeupFd[0]) {
+        close(ctx->iWakeupFd[1]);
+    }
+    free(ctx->pWakeupItem);
+    ctx->pWakeupItem = NULL;
+}
+
+void co_eventloop_wakeup(stCoEpoll_t *ctx) {
+    if (ctx->iWakeupFd[1] < 0) {
+        return;
+    }
+    unsigned long long one = 1;
+    ssize_t ret = write(ctx->iWakeupFd[1], &one, sizeof(one));
+    (void)ret;
+}
+
 stCoEpoll_t *AllocEpoll() {
     stCoEpoll_t *ctx = (stCoEpoll_t *)calloc(1, sizeof(stCoEpoll_t));
 
     ctx->iEpollFd = co_epoll_create(stCoEpoll_t::_EPOLL_SIZE);
-    ctx->pTimeout = AllocTimeout(60 * 1000);
+    ctx->pTimeout = AllocTimeout();
+    AllocWakeup(ctx);
 
     ctx->pstActiveList = (stTimeoutItemLink_t *)calloc(1, sizeof(stTimeoutItemLink_t));
     ctx->pstTimeoutList = (stTimeoutItemLink_t *)calloc(1, sizeof(stTimeoutItemLink_t));
 
+    AllocUring(ctx);
     return ctx;
 }
 
 void FreeEpoll(stCoEpoll_t *ctx) {
     if (ctx) {
+        FreeUring(ctx);
+        FreeWakeup(ctx);
         free(ctx->pstActiveList);
         free(ctx->pstTimeoutList);
         FreeTimeout(ctx->pTimeout);
@@ -885,7 +1118,7 @@ int co_poll_inner(stCoEpoll_t *ctx, struct pollfd fds[], nfds_t nfds, int timeou
 
     // 3.add timeout
 
-    unsigned long long now = GetTickMS();
+    unsigned long long now = UpdateTickMS(true);
     arg.ullExpireTime = now + timeout;
     int ret = AddTimeout(ctx->pTimeout, &arg, now);
     int iRaiseCnt = 0;
@@ -926,6 +1159,914 @@ int co_poll(stCoEpoll_t *ctx, struct pollfd fds[], nfds_t nfds, int timeout_ms)
     return co_poll_inner(ctx, fds, nfds, timeout_ms, NULL);
 }
 
+// fd event (persistent edge-triggered registration)
+//
+// the fd is added to epoll once (EPOLLET) and stays there until
+// co_fd_event_free, so waiting on it costs no epoll_ctl at all.
+// edges are latched in uiReady, the owner clears the latch
+// (co_fd_event_clear) after a read/write has drained the socket.
+struct stCoFdEvent_t;
+struct stCoFdWaiter_t : public stTimeoutItem_t {
+    stCoFdEvent_t *pEvent;
+    uint32_t uiWait;    // epoll events the coroutine is waiting for.
+    uint32_t uiRevents; // epoll events raised to the coroutine.
+    int iParked;
+};
+
+struct stCoFdEvent_t : public stTimeoutItem_t {
+    int fd;
+    int iEpollFd;
+    uint32_t uiReady; // latched edges, not consumed yet.
+    int iClosed;
+    int iWaitCnt;
+
+    stCoFdWaiter_t stReader; // POLLIN waiter.
+    stCoFdWaiter_t stWriter; // POLLOUT waiter.
+};
+
+static short FdEvent2Poll(uint32_t events) {
+    short e = EpollEvent2Poll(events);
+    if (events & EPOLLRDHUP) e |= POLLIN;  // let the reader see eof.
+    return e;
+}
+
+static void OnFdEventWake(stCoFdWaiter_t *w, stTimeoutItemLink_t *active) {
+    w->iParked = 0;
+    RemoveFromLink<stTimeoutItem_t, stTimeoutItemLink_t>(w);
+    AddTail(active, (stTimeoutItem_t *)w);
+}
+
+static void OnFdEventPreparePfn(stTimeoutItem_t *ap, struct epoll_event &e, stTimeoutItemLink_t *active) {
+    stCoFdEvent_t *ev = (stCoFdEvent_t *)ap;
+    ev->uiReady |= e.events;
+
+    uint32_t err = EPOLLERR | EPOLLHUP;
+    stCoFdWaiter_t *waiters[2] = {&ev->stReader, &ev->stWriter};
+    for (int i = 0; i < 2; i++) {
+        stCoFdWaiter_t *w = waiters[i];
+        if (w->iParked && (ev->uiReady & (w->uiWait | err))) {
+            w->uiRevents = ev->uiReady & (w->uiWait | err);
+            OnFdEventWake(w, active);
+        }
+    }
+}
+
+stCoFdEvent_t *co_fd_event_alloc(int fd) {
+    if (fd < 0) {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    stCoFdEvent_t *ev = (stCoFdEvent_t *)calloc(1, sizeof(stCoFdEvent_t));
+    if (ev == NULL) {
+        return NULL;
+    }
+
+    ev->fd = fd;
+    ev->iEpollFd = co_get_epoll_ct()->iEpollFd;
+    ev->pfnPrepare = OnFdEventPreparePfn;
+
+    ev->stReader.pEvent = ev;
+    ev->stReader.pfnProcess = OnPollProcessEvent;
+    ev->stWriter.pEvent = ev;
+    ev->stWriter.pfnProcess = OnPollProcessEvent;
+
+    struct epoll_event e;
+    memset(&e, 0, sizeof(e));
+    e.data.ptr = (stTimeoutItem_t *)ev;
+    e.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+    if (co_epoll_ctl(ev->iEpollFd, EPOLL_CTL_ADD, fd, &e) < 0) {
+        free(ev);
+        return NULL;
+    }
+    return ev;
+}
+
+void co_fd_event_free(stCoFdEvent_t *ev) {
+    if (ev == NULL || ev->iClosed) {
+        return;
+    }
+
+    struct epoll_event e;
+    memset(&e, 0, sizeof(e));
+    co_epoll_ctl(ev->iEpollFd, EPOLL_CTL_DEL, ev->fd, &e);
+    ev->iClosed = 1;
+
+    if (ev->iWaitCnt == 0) {
+        free(ev);
+        return;
+    }
+
+    // the parked coroutines release it when they are resumed.
+    stCoRoutineEnv_t *env = co_get_curr_thread_env();
+    if (env == NULL || env->pEpoll == NULL) {
+        return;
+    }
+    stTimeoutItemLink_t *active = env->pEpoll->pstActiveList;
+    stCoFdWaiter_t *waiters[2] = {&ev->stReader, &ev->stWriter};
+    for (int i = 0; i < 2; i++) {
+        if (waiters[i]->iParked) {
+            waiters[i]->uiRevents = EPOLLERR;
+            OnFdEventWake(waiters[i], active);
+        }
+    }
+}
+
+void co_fd_event_clear(stCoFdEvent_t *ev, int events) {
+    if (ev != NULL) {
+        ev->uiReady &= ~PollEvent2Epoll(events);
+    }
+}
+
+int co_fd_event_wait(stCoFdEvent_t *ev, int events, int timeout_ms) {
+    if (ev == NULL || ev->iClosed) {
+        errno = EBADF;
+        return -1;
+    }
+
+    uint32_t err = EPOLLERR | EPOLLHUP;
+    uint32_t wait = PollEvent2Epoll(events);
+    if (events & POLLIN) {
+        wait |= EPOLLRDHUP;
+    }
+
+    // edge already latched, no need to park.
+    if (ev->uiReady & (wait | err)) {
+        return FdEvent2Poll(ev->uiReady & (wait | err));
+    }
+    if (timeout_ms == 0) {
+        return 0;
+    }
+    if (timeout_ms < 0) {
+        timeout_ms = INT_MAX;
+    }
+
+    stCoFdWaiter_t *w = (events & POLLOUT) ? &ev->stWriter : &ev->stReader;
+    if (w->iParked) {
+        errno = EBUSY;
+        return -1;
+    }
+
+    stCoRoutineEnv_t *env = co_get_curr_thread_env();
+    unsigned long long now = UpdateTickMS(true);
+
+    w->pArg = GetCurrCo(env);
+    w->uiWait = wait;
+    w->uiRevents = 0;
+    w->bTimeout = false;
+    w->ullExpireTime = now + timeout_ms;
+
+    int ret = AddTimeout(env->pEpoll->pTimeout, w, now);
+    if (ret != 0) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    w->iParked = 1;
+    ev->iWaitCnt++;
+    co_yield_env(env);
+    ev->iWaitCnt--;
+    w->iParked = 0;
+    RemoveFromLink<stTimeoutItem_t, stTimeoutItemLink_t>(w);
+
+    if (ev->iClosed) {
+        if (ev->iWaitCnt == 0) {
+            free(ev);
+        }
+        errno = EBADF;
+        return -1;
+    }
+
+    return FdEvent2Poll(w->uiRevents);
+}
+
+// io engine (io_uring)
+//
+// the ring is the event loop's waiter: the epoll fd is watched by a
+// multishot poll sqe, so co_poll and fd events still work on epoll.
+// sqes queued by coroutines are submitted by one io_uring_enter per loop.
+//
+// coroutines run on shared stacks, which are copied out while they are
+// suspended, so the kernel must never write into a coroutine's stack:
+// recv selects a buffer from the provided buffer ring and copies it out
+// after the coroutine is resumed, send bounces data found on the stack.
+static int g_io_engine = CO_IO_ENGINE_EPOLL;
+
+void co_set_io_engine(int engine) {
+    g_io_engine = engine;
+}
+
+#if defined(CO_HAVE_URING)
+
+enum {
+    eUringOpEpoll = 1,
+    eUringOpIo,
+    eUringOpAccept,
+    eUringOpRecv,
+};
+
+struct stCoUringOp_t : public stTimeoutItem_t {
+    int iType;
+    int iArmed;  // sqe is in flight.
+    int iRes;
+    unsigned uFlags;
+    struct __kernel_timespec stTs;  // link timeout, alive until the op completes.
+};
+
+struct stCoUringWaiter_t : public stTimeoutItem_t {
+    int iParked;
+};
+
+// multishot op owned by a fd, freed after its last cqe.
+struct stCoUringMulti_t : public stCoUringOp_t {
+    int fd;
+    int iClosed;
+    int iErr;
+    int iWaitCnt;
+    stCoUring_t *pUring;
+    stCoUringWaiter_t stWaiter;
+};
+
+struct stCoUringAccept_t : public stCoUringMulti_t {
+    int *pFds;  // accepted fds queue.
+    int iHead;
+    int iCnt;
+    int iCap;
+};
+
+struct stCoUringBuf_t {
+    int bid;
+    int len;
+};
+
+struct stCoUringRecv_t : public stCoUringMulti_t {
+    stCoUringBuf_t *pBufs;  // filled buffers queue.
+    int iHead;
+    int iCnt;
+    int iCap;
+    int iOffset;  // read offset of the head buffer.
+    size_t uPending;
+    int iEof;
+    int iNoBufs;  // buffer ring ran out, the multishot recv stopped.
+};
+
+template <class T>
+static bool UringQueuePush(T *&items, int &head, int &cnt, int &cap, const T &v) {
+    if (cnt == cap) {
+        int new_cap = (cap == 0) ? 16 : cap * 2;
+        T *p = (T *)malloc(new_cap * sizeof(T));
+        if (p == NULL) {
+            return false;
+        }
+        for (int i = 0; i < cnt; i++) {
+            p[i] = items[(head + i) % cap];
+        }
+        free(items);
+        items = p;
+        head = 0;
+        cap = new_cap;
+    }
+    items[(head + cnt) % cap] = v;
+    cnt++;
+    return true;
+}
+
+static void AllocUring(stCoEpoll_t *ctx) {
+    if (g_io_engine != CO_IO_ENGINE_URING) {
+        return;
+    }
+
+    ctx->pUring = co_uring_alloc(1024, 1024, 4096);
+    if (ctx->pUring == NULL) {
+        return;
+    }
+    ctx->pEpollOp = (stCoUringOp_t *)calloc(1, sizeof(stCoUringOp_t));
+    ctx->pEpollOp->iType = eUringOpEpoll;
+}
+
+static void FreeUring(stCoEpoll_t *ctx) {
+    if (ctx->pUring != NULL) {
+        co_uring_free(ctx->pUring);
+        ctx->pUring = NULL;
+    }
+    free(ctx->pEpollOp);
+    ctx->pEpollOp = NULL;
+}
+
+// forked child, the parent's ring is left to the parent, the child gets its own.
+static stCoUring_t *RenewUring(stCoEpoll_t *ctx) {
+    if (ctx->pUring != NULL && co_uring_is_stale(ctx->pUring)) {
+        // alloc before free, the new ring must not reuse the old address.
+        stCoUring_t *old = ctx->pUring;
+        stCoUringOp_t *old_op = ctx->pEpollOp;
+        ctx->pUring = NULL;
+        ctx->pEpollOp = NULL;
+        AllocUring(ctx);
+        co_uring_free(old);
+        free(old_op);
+    }
+    return ctx->pUring;
+}
+
+static stCoUring_t *GetUring() {
+    stCoRoutineEnv_t *env = co_get_curr_thread_env();
+    return (env != NULL && env->pEpoll != NULL) ? RenewUring(env->pEpoll) : NULL;
+}
+
+static bool UringCancel(stCoUring_t *r, stCoUringOp_t *op) {
+    struct io_uring_sqe *sqe = co_uring_get_sqe(r);
+    if (sqe == NULL) {
+        return false;
+    }
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->addr = (unsigned long long)op;
+    sqe->user_data = 0;
+    return true;
+}
+
+static void UringWake(stCoUringMulti_t *m, stTimeoutItemLink_t *active) {
+    stCoUringWaiter_t *w = &m->stWaiter;
+    if (w->iParked) {
+        w->iParked = 0;
+        RemoveFromLink<stTimeoutItem_t, stTimeoutItemLink_t>(w);
+        AddTail(active, (stTimeoutItem_t *)w);
+    }
+}
+
+static void UringAcceptTryFree(stCoUringAccept_t *acc) {
+    if (acc->iArmed || acc->iWaitCnt > 0) {
+        return;
+    }
+    for (int i = 0; i < acc->iCnt; i++) {
+        close(acc->pFds[(acc->iHead + i) % acc->iCap]);
+    }
+    free(acc->pFds);
+    free(acc);
+}
+
+static void UringRecvTryFree(stCoUringRecv_t *rv) {
+    if (rv->iArmed || rv->iWaitCnt > 0) {
+        return;
+    }
+    if (rv->pUring == GetUring()) {
+        for (int i = 0; i < rv->iCnt; i++) {
+            co_uring_buf_recycle(rv->pUring, rv->pBufs[(rv->iHead + i) % rv->iCap].bid);
+        }
+    }
+    free(rv->pBufs);
+    free(rv);
+}
+
+static void OnUringAcceptCqe(stCoUringAccept_t *acc, struct io_uring_cqe *cqe, stTimeoutItemLink_t *active) {
+    if (!(cqe->flags & IORING_CQE_F_MORE)) {
+        acc->iArmed = 0;
+    }
+
+    if (cqe->res >= 0) {
+        if (acc->iClosed ||
+            !UringQueuePush(acc->pFds, acc->iHead, acc->iCnt, acc->iCap, (int)cqe->res)) {
+            close(cqe->res);
+        }
+    } else if (cqe->res != -ECANCELED) {
+        acc->iErr = -cqe->res;
+    }
+
+    if (acc->iClosed) {
+        UringAcceptTryFree(acc);
+    } else {
+        UringWake(acc, active);
+    }
+}
+
+static void OnUringRecvCqe(stCoUringRecv_t *rv, struct io_uring_cqe *cqe, stTimeoutItemLink_t *active) {
+    if (!(cqe->flags & IORING_CQE_F_MORE)) {
+        rv->iArmed = 0;
+    }
+
+    if (cqe->res > 0 && (cqe->flags & IORING_CQE_F_BUFFER)) {
+        stCoUringBuf_t b;
+        b.bid = cqe->flags >> IORING_CQE_BUFFER_SHIFT;
+        b.len = cqe->res;
+        if (rv->iClosed || !UringQueuePush(rv->pBufs, rv->iHead, rv->iCnt, rv->iCap, b)) {
+            co_uring_buf_recycle(rv->pUring, b.bid);
+            rv->iErr = rv->iClosed ? rv->iErr : ENOMEM;
+        } else {
+            rv->uPending += b.len;
+        }
+    } else if (cqe->res == 0) {
+        rv->iEof = 1;
+    } else if (cqe->res == -ENOBUFS) {
+        rv->iNoBufs = 1;
+    } else if (cqe->res < 0 && cqe->res != -ECANCELED) {
+        rv->iErr = -cqe->res;
+    }
+
+    if (rv->iClosed) {
+        UringRecvTryFree(rv);
+    } else {
+        UringWake(rv, active);
+    }
+}
+
+static void OnUringCqe(struct io_uring_cqe *cqe, void *arg) {
+    stCoEpoll_t *ctx = (stCoEpoll_t *)arg;
+    stCoUringOp_t *op = (stCoUringOp_t *)cqe->user_data;
+    if (op == NULL) {
+        return;  // link timeout or cancel.
+    }
+
+    switch (op->iType) {
+        case eUringOpEpoll:
+            ctx->iEpollPending = 1;
+            if (!(cqe->flags & IORING_CQE_F_MORE)) {
+                op->iArmed = 0;
+            }
+            break;
+        case eUringOpIo:
+            op->iArmed = 0;
+            op->iRes = cqe->res;
+            op->uFlags = cqe->flags;
+            AddTail(ctx->pstActiveList, (stTimeoutItem_t *)op);
+            break;
+        case eUringOpAccept:
+            OnUringAcceptCqe((stCoUringAccept_t *)op, cqe, ctx->pstActiveList);
+            break;
+        case eUringOpRecv:
+            OnUringRecvCqe((stCoUringRecv_t *)op, cqe, ctx->pstActiveList);
+            break;
+        default:
+            break;
+    }
+}
+
+static int UringWait(stCoEpoll_t *ctx, co_epoll_res *result, int timeout) {
+    if (RenewUring(ctx) == NULL) {
+        return co_epoll_wait(ctx->iEpollFd, result, stCoEpoll_t::_EPOLL_SIZE, timeout);
+    }
+
+    stCoUring_t *r = ctx->pUring;
+    stCoUringOp_t *pop = ctx->pEpollOp;
+
+    if (!pop->iArmed) {
+        struct io_uring_sqe *sqe = co_uring_get_sqe(r);
+        if (sqe != NULL) {
+            sqe->opcode = IORING_OP_POLL_ADD;
+            sqe->fd = ctx->iEpollFd;
+            sqe->poll32_events = POLLIN;
+            sqe->len = IORING_POLL_ADD_MULTI;
+            sqe->user_data = (unsigned long long)pop;
+            pop->iArmed = 1;
+        }
+    }
+
+    co_uring_submit(r, ctx->iEpollPending ? 0 : timeout);
+    co_uring_reap(r, OnUringCqe, ctx);
+
+    if (!ctx->iEpollPending) {
+        return 0;
+    }
+
+    // level-triggered fds do not wake the poll again, fetch until it is empty.
+    int ret = co_epoll_wait(ctx->iEpollFd, result, stCoEpoll_t::_EPOLL_SIZE, 0);
+    ctx->iEpollPending = (ret > 0);
+    return (ret > 0) ? ret : 0;
+}
+
+static int UringMultiWait(stCoUringMulti_t *m, int timeout_ms) {
+    stCoUringWaiter_t *w = &m->stWaiter;
+    if (w->iParked) {
+        errno = EBUSY;
+        return -1;
+    }
+    if (timeout_ms < 0) {
+        timeout_ms = INT_MAX;
+    }
+
+    stCoRoutineEnv_t *env = co_get_curr_thread_env();
+    unsigned long long now = UpdateTickMS(true);
+
+    w->pArg = GetCurrCo(env);
+    w->bTimeout = false;
+    w->ullExpireTime = now + timeout_ms;
+
+    if (AddTimeout(env->pEpoll->pTimeout, w, now) != 0) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    w->iParked = 1;
+    m->iWaitCnt++;
+    co_yield_env(env);
+    m->iWaitCnt--;
+    w->iParked = 0;
+    RemoveFromLink<stTimeoutItem_t, stTimeoutItemLink_t>(w);
+    return 0;
+}
+
+static void UringMultiClose(stCoUringMulti_t *m) {
+    m->iClosed = 1;
+    if (m->iArmed) {
+        if (m->pUring != GetUring() || co_uring_is_stale(m->pUring)) {
+            m->iArmed = 0;  // the ring is gone (env freed) or owned by parent (fork).
+        } else if (!UringCancel(m->pUring, m)) {
+            co_log_err("CO_ERR: cancel multishot op failed, fd %d", m->fd);
+        }
+    }
+
+    stCoRoutineEnv_t *env = co_get_curr_thread_env();
+    if (env != NULL && env->pEpoll != NULL) {
+        UringWake(m, env->pEpoll->pstActiveList);
+    }
+}
+
+static stCoUringOp_t *UringIoAlloc(stCoUring_t *r, int timeout_ms) {
+    // op and its link timeout are queued together.
+    if (co_uring_sq_space(r) < 2) {
+        co_uring_submit(r, 0);
+        if (co_uring_sq_space(r) < 2) {
+            return NULL;
+        }
+    }
+
+    stCoUringOp_t *op = (stCoUringOp_t *)calloc(1, sizeof(stCoUringOp_t));
+    if (op == NULL) {
+        return NULL;
+    }
+    op->iType = eUringOpIo;
+    op->pfnProcess = OnPollProcessEvent;
+    op->pArg = GetCurrCo(co_get_curr_thread_env());
+    if (timeout_ms > 0) {
+        op->stTs.tv_sec = timeout_ms / 1000;
+        op->stTs.tv_nsec = (timeout_ms % 1000) * 1000000LL;
+    }
+    return op;
+}
+
+static int UringIoSubmitWait(stCoUring_t *r, stCoUringOp_t *op, struct io_uring_sqe *sqe, int timeout_ms) {
+    sqe->user_data = (unsigned long long)op;
+    if (timeout_ms > 0) {
+        sqe->flags |= IOSQE_IO_LINK;
+        struct io_uring_sqe *t = co_uring_get_sqe(r);
+        t->opcode = IORING_OP_LINK_TIMEOUT;
+        t->addr = (unsigned long long)&op->stTs;
+        t->len = 1;
+        t->user_data = 0;
+    }
+
+    // the buffers belong to the kernel until the op's cqe arrives.
+    op->iArmed = 1;
+    stCoRoutineEnv_t *env = co_get_curr_thread_env();
+    while (op->iArmed) {
+        co_yield_env(env);
+    }
+    return op->iRes;
+}
+
+static bool UringIsOnShareStack(const void *buf) {
+    stCoRoutine_t *self = co_self();
+    if (self == NULL || !self->cIsShareStack || self->stack_mem == NULL) {
+        return false;
+    }
+    const char *p = (const char *)buf;
+    return p >= self->stack_mem->stack_buffer && p < self->stack_mem->stack_bp;
+}
+
+ssize_t co_uring_recv(int fd, void *buf, size_t len, int flags, int timeout_ms) {
+    stCoUring_t *r = GetUring();
+    stCoRoutine_t *self = co_self();
+    if (r == NULL || self == NULL || self->cIsMain) {
+        errno = ENOSYS;
+        return -1;
+    }
+
+    stCoUringOp_t *op = UringIoAlloc(r, timeout_ms);
+    if (op == NULL) {
+        errno = ENOSYS;
+        return -1;
+    }
+
+    struct io_uring_sqe *sqe = co_uring_get_sqe(r);
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = fd;
+    sqe->len = (len < co_uring_buf_size(r)) ? len : co_uring_buf_size(r);
+    sqe->msg_flags = flags;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = CO_URING_BUF_GROUP;
+
+    int res = UringIoSubmitWait(r, op, sqe, timeout_ms);
+    unsigned cflags = op->uFlags;
+    free(op);
+
+    if (res > 0 && (cflags & IORING_CQE_F_BUFFER)) {
+        int bid = cflags >> IORING_CQE_BUFFER_SHIFT;
+        memcpy(buf, co_uring_buf(r, bid), res);
+        co_uring_buf_recycle(r, bid);
+        return res;
+    } else if (res >= 0) {
+        return res;
+    }
+
+    errno = (res == -ECANCELED) ? EAGAIN : -res;
+    return -1;
+}
+
+ssize_t co_uring_send(int fd, const void *buf, size_t len, int flags, int timeout_ms) {
+    stCoUring_t *r = GetUring();
+    stCoRoutine_t *self = co_self();
+    if (r == NULL || self == NULL || self->cIsMain) {
+        errno = ENOSYS;
+        return -1;
+    }
+
+    const char *data = (const char *)buf;
+    char *bounce = NULL;
+    if (UringIsOnShareStack(buf)) {
+        bounce = (char *)malloc(len);
+        if (bounce == NULL) {
+            errno = ENOSYS;
+            return -1;
+        }
+        memcpy(bounce, buf, len);
+        data = bounce;
+    }
+
+    size_t sent = 0;
+    int res = 0;
+    while (sent < len) {
+        stCoUringOp_t *op = UringIoAlloc(r, timeout_ms);
+        if (op == NULL) {
+            res = (sent == 0) ? -ENOSYS : 0;
+            break;
+        }
+
+        struct io_uring_sqe *sqe = co_uring_get_sqe(r);
+        sqe->opcode = IORING_OP_SEND;
+        sqe->fd = fd;
+        sqe->addr = (unsigned long long)(data + sent);
+        sqe->len = len - sent;
+        sqe->msg_flags = flags;
+
+        res = UringIoSubmitWait(r, op, sqe, timeout_ms);
+        free(op);
+        if (res <= 0) {
+            break;
+        }
+        sent += res;
+    }
+    free(bounce);
+
+    if (sent > 0 || res == 0) {
+        return sent;
+    }
+    errno = (res == -ECANCELED) ? EAGAIN : -res;
+    return -1;
+}
+
+stCoUringAccept_t *co_uring_accept_alloc(int fd) {
+    stCoUring_t *r = GetUring();
+    if (r == NULL || fd < 0) {
+        return NULL;
+    }
+
+    stCoUringAccept_t *acc = (stCoUringAccept_t *)calloc(1, sizeof(stCoUringAccept_t));
+    if (acc == NULL) {
+        return NULL;
+    }
+    acc->iType = eUringOpAccept;
+    acc->fd = fd;
+    acc->pUring = r;
+    acc->stWaiter.pfnProcess = OnPollProcessEvent;
+    return acc;
+}
+
+static void UringArmAccept(stCoUringAccept_t *acc) {
+    if (acc->iArmed || acc->iClosed) {
+        return;
+    }
+    struct io_uring_sqe *sqe = co_uring_get_sqe(acc->pUring);
+    if (sqe == NULL) {
+        return;
+    }
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->fd = acc->fd;
+    sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+    sqe->user_data = (unsigned long long)acc;
+    acc->iArmed = 1;
+}
+
+void co_uring_accept_free(stCoUringAccept_t *acc) {
+    if (acc == NULL || acc->iClosed) {
+        return;
+    }
+    UringMultiClose(acc);
+    UringAcceptTryFree(acc);
+}
+
+int co_uring_accept(stCoUringAccept_t *acc) {
+    if (acc == NULL || acc->iClosed) {
+        errno = EBADF;
+        return -1;
+    }
+
+    if (acc->iCnt > 0) {
+        int fd = acc->pFds[acc->iHead];
+        acc->iHead = (acc->iHead + 1) % acc->iCap;
+        acc->iCnt--;
+        return fd;
+    }
+
+    if (acc->iErr) {
+        errno = acc->iErr;
+        acc->iErr = 0;
+        return -1;
+    }
+
+    UringArmAccept(acc);
+    errno = EAGAIN;
+    return -1;
+}
+
+int co_uring_accept_wait(stCoUringAccept_t *acc, int timeout_ms) {
+    if (acc == NULL || acc->iClosed) {
+        errno = EBADF;
+        return -1;
+    }
+
+    if (acc->iCnt == 0 && acc->iErr == 0) {
+        UringArmAccept(acc);
+        if (timeout_ms == 0 || UringMultiWait(acc, timeout_ms) != 0) {
+            return 0;
+        }
+        if (acc->iClosed) {
+            UringAcceptTryFree(acc);
+            errno = EBADF;
+            return -1;
+        }
+    }
+    return (acc->iCnt > 0 || acc->iErr != 0) ? 1 : 0;
+}
+
+stCoUringRecv_t *co_uring_recv_alloc(int fd) {
+    stCoUring_t *r = GetUring();
+    if (r == NULL || fd < 0) {
+        return NULL;
+    }
+
+    stCoUringRecv_t *rv = (stCoUringRecv_t *)calloc(1, sizeof(stCoUringRecv_t));
+    if (rv == NULL) {
+        return NULL;
+    }
+    rv->iType = eUringOpRecv;
+    rv->fd = fd;
+    rv->pUring = r;
+    rv->stWaiter.pfnProcess = OnPollProcessEvent;
+    return rv;
+}
+
+static void UringArmRecv(stCoUringRecv_t *rv) {
+    if (rv->iArmed || rv->iClosed || rv->iEof || rv->iErr) {
+        return;
+    }
+    struct io_uring_sqe *sqe = co_uring_get_sqe(rv->pUring);
+    if (sqe == NULL) {
+        return;
+    }
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = rv->fd;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = CO_URING_BUF_GROUP;
+    sqe->user_data = (unsigned long long)rv;
+    rv->iArmed = 1;
+    rv->iNoBufs = 0;
+}
+
+void co_uring_recv_free(stCoUringRecv_t *rv) {
+    if (rv == NULL || rv->iClosed) {
+        return;
+    }
+    UringMultiClose(rv);
+    UringRecvTryFree(rv);
+}
+
+size_t co_uring_recv_pending(stCoUringRecv_t *rv) {
+    return (rv != NULL) ? rv->uPending : 0;
+}
+
+ssize_t co_uring_recv_read(stCoUringRecv_t *rv, void *buf, size_t len) {
+    if (rv == NULL || rv->iClosed) {
+        errno = EBADF;
+        return -1;
+    }
+
+    size_t n = 0;
+    while (n < len && rv->iCnt > 0) {
+        stCoUringBuf_t &b = rv->pBufs[rv->iHead];
+        size_t avail = b.len - rv->iOffset;
+        size_t cnt = (avail < len - n) ? avail : len - n;
+
+        memcpy((char *)buf + n, co_uring_buf(rv->pUring, b.bid) + rv->iOffset, cnt);
+        n += cnt;
+        rv->iOffset += cnt;
+        rv->uPending -= cnt;
+
+        if (rv->iOffset == b.len) {
+            co_uring_buf_recycle(rv->pUring, b.bid);
+            rv->iHead = (rv->iHead + 1) % rv->iCap;
+            rv->iCnt--;
+            rv->iOffset = 0;
+        }
+    }
+
+    if (n > 0) {
+        return n;
+    }
+    if (rv->iErr) {
+        errno = rv->iErr;
+        return -1;
+    }
+    if (rv->iEof) {
+        return 0;
+    }
+    if (rv->iNoBufs && !rv->iArmed) {
+        // queue is drained, the caller reads the socket itself this time.
+        rv->iNoBufs = 0;
+        errno = ENOBUFS;
+        return -1;
+    }
+    errno = EAGAIN;
+    return -1;
+}
+
+int co_uring_recv_wait(stCoUringRecv_t *rv, int timeout_ms) {
+    if (rv == NULL || rv->iClosed) {
+        errno = EBADF;
+        return -1;
+    }
+
+    if (rv->iCnt == 0 && !rv->iEof && !rv->iErr && !rv->iNoBufs) {
+        UringArmRecv(rv);
+        if (timeout_ms == 0 || UringMultiWait(rv, timeout_ms) != 0) {
+            return 0;
+        }
+        if (rv->iClosed) {
+            UringRecvTryFree(rv);
+            errno = EBADF;
+            return -1;
+        }
+    }
+    return (rv->iCnt > 0 || rv->iEof || rv->iErr || rv->iNoBufs) ? 1 : 0;
+}
+
+int co_get_io_engine() {
+    return (RenewUring(co_get_epoll_ct()) != NULL) ? CO_IO_ENGINE_URING : CO_IO_ENGINE_EPOLL;
+}
+
+#else
+
+static void AllocUring(stCoEpoll_t *) {}
+static void FreeUring(stCoEpoll_t *) {}
+static int UringWait(stCoEpoll_t *, co_epoll_res *, int) { return 0; }
+
+int co_get_io_engine() {
+    return CO_IO_ENGINE_EPOLL;
+}
+
+ssize_t co_uring_recv(int, void *, size_t, int, int) {
+    errno = ENOSYS;
+    return -1;
+}
+
+ssize_t co_uring_send(int, const void *, size_t, int, int) {
+    errno = ENOSYS;
+    return -1;
+}
+
+stCoUringAccept_t *co_uring_accept_alloc(int) { return NULL; }
+void co_uring_accept_free(stCoUringAccept_t *) {}
+int co_uring_accept(stCoUringAccept_t *) {
+    errno = EBADF;
+    return -1;
+}
+int co_uring_accept_wait(stCoUringAccept_t *, int) {
+    errno = EBADF;
+    return -1;
+}
+
+stCoUringRecv_t *co_uring_recv_alloc(int) { return NULL; }
+void co_uring_recv_free(stCoUringRecv_t *) {}
+size_t co_uring_recv_pending(stCoUringRecv_t *) { return 0; }
+ssize_t co_uring_recv_read(stCoUringRecv_t *, void *, size_t) {
+    errno = EBADF;
+    return -1;
+}
+int co_uring_recv_wait(stCoUringRecv_t *, int) {
+    errno = EBADF;
+    return -1;
+}
+
+#endif
+
 void SetEpoll(stCoRoutineEnv_t *env, stCoEpoll_t *ev) {
     env->pEpoll = ev;
 }
@@ -1028,7 +2169,7 @@ int co_cond_timedwait(stCoCond_t *link, int ms) {
     psi->timeout.pfnProcess = OnSignalProcessEvent;
 
     if (ms > 0) {
-        unsigned long long now = GetTickMS();
+        unsigned long long now = UpdateTickMS(true);
         psi->timeout.ullExpireTime = now + ms;
 
         int ret = AddTimeout(co_get_curr_thread_env()->pEpoll->pTimeout, &psi->timeout, now);
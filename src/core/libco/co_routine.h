@@ -22,6 +22,7 @@
 #include <pthread.h>
 #include <stdint.h>
 #include <sys/poll.h>
+#include <sys/types.h>
 
 #include <functional>
 
@@ -58,6 +59,9 @@ stCoRoutine_t *co_self();
 void FreeLibcoEnv();
 int co_poll(stCoEpoll_t *ctx, struct pollfd fds[], nfds_t nfds, int timeout_ms);
 void co_eventloop(stCoEpoll_t *ctx, pfn_co_eventloop_t pfn = nullptr, void *arg = nullptr);
+// the loop sleeps until the earliest timeout (1s at most), wakes it up at once.
+// thread safe, pfn can call it to run the loop again without waiting.
+void co_eventloop_wakeup(stCoEpoll_t *ctx);
 
 // 3.specific
 
@@ -89,8 +93,64 @@ stShareStack_t *co_alloc_sharestack(int iCount, int iStackSize);
 
 void co_release_sharestack(stShareStack_t *mem);
 
+// current thread's stack data copied out by save_stack_buffer,
+// when a coroutine is switched out from its shared stack.
+struct stCoStackStat_t {
+    unsigned long long save_cnt;
+    unsigned long long save_bytes;
+    unsigned int max_save_size;
+};
+
+void co_get_stack_stat(stCoStackStat_t *stat);
+
 // 8.init envlist for hook get/set env
 void co_set_env_list(const char *name[], size_t cnt);
 
+// 9.fd event, keep fd registered in epoll (edge-triggered) for its whole life.
+struct stCoFdEvent_t;
+
+stCoFdEvent_t *co_fd_event_alloc(int fd);
+void co_fd_event_free(stCoFdEvent_t *ev);
+void co_fd_event_clear(stCoFdEvent_t *ev, int events);  // socket drained (EAGAIN).
+int co_fd_event_wait(stCoFdEvent_t *ev, int events, int timeout_ms);  // poll revents, 0: timeout.
+
+// 10.io engine, io_uring submits hooked sockets' reads/writes as sqes.
+// set before the thread's event loop is created, it falls back to epoll
+// automatically if the kernel can not support it.
+enum {
+    CO_IO_ENGINE_EPOLL = 0,
+    CO_IO_ENGINE_URING = 1,
+};
+
+void co_set_io_engine(int engine);
+int co_get_io_engine();  // the engine in use.
+
+// hooked blocking sockets, -1 & EAGAIN: timeout.
+ssize_t co_uring_recv(int fd, void *buf, size_t len, int flags, int timeout_ms);
+ssize_t co_uring_send(int fd, const void *buf, size_t len, int flags, int timeout_ms);
+
+// multishot accept, one sqe keeps accepting until it is freed.
+struct stCoUringAccept_t;
+
+stCoUringAccept_t *co_uring_accept_alloc(int fd);  // NULL: not io_uring engine.
+void co_uring_accept_free(stCoUringAccept_t *acc);
+int co_uring_accept(stCoUringAccept_t *acc);  // accepted fd, -1 & EAGAIN: none.
+int co_uring_accept_wait(stCoUringAccept_t *acc, int timeout_ms);  // 1: ready, 0: timeout.
+
+// multishot recv into the provided buffer ring, data is queued until it is read.
+struct stCoUringRecv_t;
+
+stCoUringRecv_t *co_uring_recv_alloc(int fd);  // NULL: not io_uring engine.
+void co_uring_recv_free(stCoUringRecv_t *rv);
+size_t co_uring_recv_pending(stCoUringRecv_t *rv);  // queued bytes.
+ssize_t co_uring_recv_read(stCoUringRecv_t *rv, void *buf, size_t len);  // 0: eof, -1 & EAGAIN: none.
+int co_uring_recv_wait(stCoUringRecv_t *rv, int timeout_ms);  // 1: ready, 0: timeout.
+
+// 11.loop clock, monotonic milliseconds (not the wall clock).
+// co_tick_ms is ticked once per co_eventloop iteration (CLOCK_MONOTONIC_COARSE),
+// it is cheap to read, threads without an event loop need the precise one.
+unsigned long long co_tick_ms();
+unsigned long long co_tick_ms_precise();  // reads CLOCK_MONOTONIC and ticks the loop clock.
+
 void co_log_err(const char *fmt, ...);
 #endif
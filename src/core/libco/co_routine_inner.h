@@ -81,7 +81,7 @@ void co_yield_env(stCoRoutineEnv_t *env);
 struct stTimeout_t;
 struct stTimeoutItem_t;
 
-stTimeout_t *AllocTimeout(int iSize);
+stTimeout_t *AllocTimeout();
 void FreeTimeout(stTimeout_t *apTimeout);
 int AddTimeout(stTimeout_t *apTimeout, stTimeoutItem_t *apItem, uint64_t allNow);
 
@@ -0,0 +1,359 @@
+/*
+* Tencent is pleased to support the open source community by making Libco available.
+
+* Copyright (C) 2014 THL A29 Limited, a Tencent company. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*	http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing,
+* software distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "co_uring.h"
+
+#if defined(CO_HAVE_URING)
+
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <sys/mman.h>
+#include <sys/utsname.h>
+#include <time.h>
+#include <unistd.h>
+
+struct stCoUring_t {
+    int iRingFd;
+    int iGeneration;  // the ring is shared with the parent after fork, never touch it.
+
+    // sq
+    unsigned *pSqHead;
+    unsigned *pSqTail;
+    unsigned *pSqArray;
+    unsigned uSqMask;
+    unsigned uSqEntries;
+    unsigned uSqTail;  // local tail, published on submit.
+    unsigned uToSubmit;
+    struct io_uring_sqe *pSqes;
+
+    // cq
+    unsigned *pCqHead;
+    unsigned *pCqTail;
+    unsigned uCqMask;
+    struct io_uring_cqe *pCqes;
+
+    void *pRing;
+    size_t uRingSize;
+    size_t uSqesSize;
+
+    // provided buffer ring.
+    struct io_uring_buf *pBufRing;
+    size_t uBufRingSize;
+    char *pBufs;
+    unsigned uBufCnt;
+    unsigned uBufSize;
+    unsigned short uBufTail;
+};
+
+static int s_uring_generation = 0;
+static pthread_once_t s_uring_once = PTHREAD_ONCE_INIT;
+
+static void OnUringForkChild() {
+    s_uring_generation++;
+}
+
+static void UringAtFork() {
+    pthread_atfork(NULL, NULL, OnUringForkChild);
+}
+
+static inline int sys_io_uring_setup(unsigned entries, struct io_uring_params *p) {
+    return (int)syscall(__NR_io_uring_setup, entries, p);
+}
+
+static inline int sys_io_uring_enter(int fd, unsigned to_submit, unsigned min_complete,
+                                     unsigned flags, void *arg, size_t argsz) {
+    return (int)syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, arg, argsz);
+}
+
+static inline int sys_io_uring_register(int fd, unsigned op, void *arg, unsigned nr_args) {
+    return (int)syscall(__NR_io_uring_register, fd, op, arg, nr_args);
+}
+
+// multishot recv has no feature flag, it comes with 6.0.
+static bool UringCheckKernel() {
+    struct utsname u;
+    int major = 0, minor = 0;
+    if (uname(&u) != 0 || sscanf(u.release, "%d.%d", &major, &minor) != 2) {
+        return false;
+    }
+    return major >= 6;
+}
+
+static bool UringProbeOps(int fd) {
+    const int cnt = 256;
+    size_t len = sizeof(struct io_uring_probe) + cnt * sizeof(struct io_uring_probe_op);
+    struct io_uring_probe *probe = (struct io_uring_probe *)calloc(1, len);
+    if (probe == NULL) {
+        return false;
+    }
+
+    bool ok = false;
+    if (sys_io_uring_register(fd, IORING_REGISTER_PROBE, probe, cnt) == 0) {
+        int ops[] = {IORING_OP_RECV, IORING_OP_SEND, IORING_OP_ACCEPT, IORING_OP_POLL_ADD,
+                     IORING_OP_LINK_TIMEOUT, IORING_OP_ASYNC_CANCEL};
+        ok = true;
+        for (size_t i = 0; i < sizeof(ops) / sizeof(ops[0]); i++) {
+            if (ops[i] > probe->last_op ||
+                !(probe->ops[ops[i]].flags & IO_URING_OP_SUPPORTED)) {
+                ok = false;
+                break;
+            }
+        }
+    }
+    free(probe);
+    return ok;
+}
+
+static bool UringSetupBufRing(stCoUring_t *r, unsigned buf_cnt, unsigned buf_size) {
+    r->uBufRingSize = buf_cnt * sizeof(struct io_uring_buf);
+    void *ring = mmap(NULL, r->uBufRingSize, PROT_READ | PROT_WRITE,
+                      MAP_ANONYMOUS | MAP_PRIVATE, -1, 0);
+    if (ring == MAP_FAILED) {
+        return false;
+    }
+    r->pBufRing = (struct io_uring_buf *)ring;
+
+    r->pBufs = (char *)malloc((size_t)buf_cnt * buf_size);
+    if (r->pBufs == NULL) {
+        return false;
+    }
+    r->uBufCnt = buf_cnt;
+    r->uBufSize = buf_size;
+
+    struct io_uring_buf_reg reg;
+    memset(&reg, 0, sizeof(reg));
+    reg.ring_addr = (unsigned long)ring;
+    reg.ring_entries = buf_cnt;
+    reg.bgid = CO_URING_BUF_GROUP;
+    if (sys_io_uring_register(r->iRingFd, IORING_REGISTER_PBUF_RING, &reg, 1) != 0) {
+        return false;
+    }
+
+    for (unsigned i = 0; i < buf_cnt; i++) {
+        co_uring_buf_recycle(r, i);
+    }
+    return true;
+}
+
+stCoUring_t *co_uring_alloc(unsigned entries, unsigned buf_cnt, unsigned buf_size) {
+    if (buf_cnt == 0 || (buf_cnt & (buf_cnt - 1)) || buf_cnt > 32768 || buf_size == 0) {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    if (!UringCheckKernel()) {
+        errno = ENOSYS;
+        return NULL;
+    }
+
+    pthread_once(&s_uring_once, UringAtFork);
+
+    struct io_uring_params p;
+    memset(&p, 0, sizeof(p));
+    // multishot ops post many cqes for one sqe.
+    p.flags = IORING_SETUP_CLAMP | IORING_SETUP_SUBMIT_ALL | IORING_SETUP_CQSIZE;
+    p.cq_entries = entries * 8;
+
+    int fd = sys_io_uring_setup(entries, &p);
+    if (fd < 0) {
+        return NULL;
+    }
+
+    unsigned need = IORING_FEAT_SINGLE_MMAP | IORING_FEAT_NODROP | IORING_FEAT_EXT_ARG;
+    if ((p.features & need) != need || !UringProbeOps(fd)) {
+        close(fd);
+        errno = ENOSYS;
+        return NULL;
+    }
+
+    stCoUring_t *r = (stCoUring_t *)calloc(1, sizeof(stCoUring_t));
+    if (r == NULL) {
+        close(fd);
+        return NULL;
+    }
+    r->iRingFd = fd;
+    r->iGeneration = s_uring_generation;
+
+    size_t sq_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    size_t cq_size = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    r->uRingSize = (sq_size > cq_size) ? sq_size : cq_size;
+
+    r->pRing = mmap(NULL, r->uRingSize, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    if (r->pRing == MAP_FAILED) {
+        r->pRing = NULL;
+        co_uring_free(r);
+        return NULL;
+    }
+
+    r->uSqesSize = p.sq_entries * sizeof(struct io_uring_sqe);
+    void *sqes = mmap(NULL, r->uSqesSize, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+        co_uring_free(r);
+        return NULL;
+    }
+    r->pSqes = (struct io_uring_sqe *)sqes;
+
+    char *ring = (char *)r->pRing;
+    r->pSqHead = (unsigned *)(ring + p.sq_off.head);
+    r->pSqTail = (unsigned *)(ring + p.sq_off.tail);
+    r->pSqArray = (unsigned *)(ring + p.sq_off.array);
+    r->uSqMask = *(unsigned *)(ring + p.sq_off.ring_mask);
+    r->uSqEntries = *(unsigned *)(ring + p.sq_off.ring_entries);
+    r->uSqTail = *r->pSqTail;
+
+    r->pCqHead = (unsigned *)(ring + p.cq_off.head);
+    r->pCqTail = (unsigned *)(ring + p.cq_off.tail);
+    r->uCqMask = *(unsigned *)(ring + p.cq_off.ring_mask);
+    r->pCqes = (struct io_uring_cqe *)(ring + p.cq_off.cqes);
+
+    if (!UringSetupBufRing(r, buf_cnt, buf_size)) {
+        co_uring_free(r);
+        errno = ENOSYS;
+        return NULL;
+    }
+
+    return r;
+}
+
+void co_uring_free(stCoUring_t *r) {
+    if (r == NULL) {
+        return;
+    }
+    if (r->pSqes) munmap(r->pSqes, r->uSqesSize);
+    if (r->pRing) munmap(r->pRing, r->uRingSize);
+    if (r->iRingFd >= 0) close(r->iRingFd);
+    if (r->pBufRing) munmap(r->pBufRing, r->uBufRingSize);
+    free(r->pBufs);
+    free(r);
+}
+
+int co_uring_is_stale(stCoUring_t *r) {
+    return r->iGeneration != s_uring_generation;
+}
+
+unsigned co_uring_sq_space(stCoUring_t *r) {
+    unsigned head = __atomic_load_n(r->pSqHead, __ATOMIC_ACQUIRE);
+    return r->uSqEntries - (r->uSqTail - head);
+}
+
+struct io_uring_sqe *co_uring_get_sqe(stCoUring_t *r) {
+    if (co_uring_is_stale(r)) {
+        return NULL;
+    }
+
+    if (co_uring_sq_space(r) == 0) {
+        co_uring_submit(r, 0);
+        if (co_uring_sq_space(r) == 0) {
+            return NULL;
+        }
+    }
+
+    unsigned idx = r->uSqTail & r->uSqMask;
+    struct io_uring_sqe *sqe = &r->pSqes[idx];
+    memset(sqe, 0, sizeof(*sqe));
+    r->pSqArray[idx] = idx;
+    r->uSqTail++;
+    r->uToSubmit++;
+    return sqe;
+}
+
+int co_uring_submit(stCoUring_t *r, int wait_ms) {
+    if (co_uring_is_stale(r)) {
+        return 0;
+    }
+
+    __atomic_store_n(r->pSqTail, r->uSqTail, __ATOMIC_RELEASE);
+
+    unsigned flags = 0, min_complete = 0;
+    struct __kernel_timespec ts;
+    struct io_uring_getevents_arg arg;
+    memset(&arg, 0, sizeof(arg));
+
+    bool cq_empty = (*r->pCqHead == __atomic_load_n(r->pCqTail, __ATOMIC_ACQUIRE));
+    if (wait_ms > 0 && cq_empty) {
+        ts.tv_sec = wait_ms / 1000;
+        ts.tv_nsec = (wait_ms % 1000) * 1000000LL;
+        arg.sigmask_sz = _NSIG / 8;
+        arg.ts = (unsigned long long)&ts;
+        flags = IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG;
+        min_complete = 1;
+    }
+
+    if (r->uToSubmit == 0 && min_complete == 0) {
+        return 0;
+    }
+
+    int ret = sys_io_uring_enter(r->iRingFd, r->uToSubmit, min_complete, flags,
+                                 (flags & IORING_ENTER_EXT_ARG) ? &arg : NULL,
+                                 (flags & IORING_ENTER_EXT_ARG) ? sizeof(arg) : 0);
+    if (ret < 0) {
+        // ETIME: wait timeout, EINTR: signal, EBUSY/EAGAIN: retry next time.
+        if (errno == ETIME || errno == EINTR) {
+            return 0;
+        }
+        return -1;
+    }
+
+    // IORING_SETUP_SUBMIT_ALL, the kernel consumes all the sqes.
+    r->uToSubmit = ((unsigned)ret >= r->uToSubmit) ? 0 : r->uToSubmit - ret;
+    return ret;
+}
+
+int co_uring_reap(stCoUring_t *r, pfn_co_uring_cqe_t pfn, void *arg) {
+    unsigned head = *r->pCqHead;
+    unsigned tail = __atomic_load_n(r->pCqTail, __ATOMIC_ACQUIRE);
+    int cnt = 0;
+
+    while (head != tail) {
+        struct io_uring_cqe *cqe = &r->pCqes[head & r->uCqMask];
+        pfn(cqe, arg);
+        head++;
+        cnt++;
+        __atomic_store_n(r->pCqHead, head, __ATOMIC_RELEASE);
+        if (head == tail) {
+            tail = __atomic_load_n(r->pCqTail, __ATOMIC_ACQUIRE);
+        }
+    }
+    return cnt;
+}
+
+char *co_uring_buf(stCoUring_t *r, int bid) {
+    return r->pBufs + (size_t)bid * r->uBufSize;
+}
+
+unsigned co_uring_buf_size(stCoUring_t *r) {
+    return r->uBufSize;
+}
+
+void co_uring_buf_recycle(stCoUring_t *r, int bid) {
+    struct io_uring_buf *buf = &r->pBufRing[r->uBufTail & (r->uBufCnt - 1)];
+    buf->addr = (unsigned long)co_uring_buf(r, bid);
+    buf->len = r->uBufSize;
+    buf->bid = (unsigned short)bid;
+    r->uBufTail++;
+    // ring's tail overlays the resv field of the first entry.
+    __atomic_store_n(&r->pBufRing[0].resv, r->uBufTail, __ATOMIC_RELEASE);
+}
+
+#endif
@@ -0,0 +1,65 @@
+/*
+* Tencent is pleased to support the open source community by making Libco available.
+
+* Copyright (C) 2014 THL A29 Limited, a Tencent company. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*	http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing,
+* software distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#ifndef __CO_URING_H__
+#define __CO_URING_H__
+
+// io_uring ring on raw syscalls (no liburing).
+// the engine needs multishot accept/recv, provided buffer ring and
+// timeout wait (IORING_ENTER_EXT_ARG), the kernel must be >= 6.0,
+// otherwise co_uring_alloc fails and libco keeps working on epoll.
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#if defined(__NR_io_uring_setup) && defined(IORING_RECV_MULTISHOT)
+#define CO_HAVE_URING 1
+#endif
+#endif
+#endif
+
+#if defined(CO_HAVE_URING)
+
+#define CO_URING_BUF_GROUP 0
+
+struct stCoUring_t;
+
+// entries: sq size, buf_cnt (power of 2) * buf_size: provided buffer ring.
+stCoUring_t *co_uring_alloc(unsigned entries, unsigned buf_cnt, unsigned buf_size);
+void co_uring_free(stCoUring_t *r);
+
+// zeroed sqe, NULL if the sq is still full after a submit,
+// or the ring belongs to the parent process (fork).
+struct io_uring_sqe *co_uring_get_sqe(stCoUring_t *r);
+unsigned co_uring_sq_space(stCoUring_t *r);
+int co_uring_is_stale(stCoUring_t *r);  // inherited from the parent process.
+
+// submit sqes, wait at most wait_ms for a cqe if there is none yet.
+int co_uring_submit(stCoUring_t *r, int wait_ms);
+
+typedef void (*pfn_co_uring_cqe_t)(struct io_uring_cqe *cqe, void *arg);
+int co_uring_reap(stCoUring_t *r, pfn_co_uring_cqe_t pfn, void *arg);
+
+// provided buffers (group CO_URING_BUF_GROUP), selected by kernel on recv.
+char *co_uring_buf(stCoUring_t *r, int bid);
+unsigned co_uring_buf_size(stCoUring_t *r);
+void co_uring_buf_recycle(stCoUring_t *r, int bid);
+
+#endif
+#endif
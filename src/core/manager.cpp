@@ -11,6 +11,8 @@
 namespace kim {
 
 void* Manager::m_signal_user_data = nullptr;
+volatile sig_atomic_t Manager::m_child_signal = 0;
+volatile sig_atomic_t Manager::m_stop_signal = 0;
 
 Manager::Manager() {
 }
@@ -51,6 +53,11 @@ bool Manager::init(const char* config_path) {
         return false;
     }
 
+    if (!load_reuseport_fds()) {
+        LOG_ERROR("load reuseport fds failed!");
+        return false;
+    }
+
     create_workers();
     load_signals();
     init_timer();
@@ -61,6 +68,8 @@ bool Manager::init(const char* config_path) {
 void Manager::on_repeat_timer() {
     co_enable_hook_sys();
 
+    handle_signals();
+
     run_with_period(1000) {
         restart_workers();
     }
@@ -91,6 +100,11 @@ bool Manager::load_logger() {
         return false;
     }
 
+    if (m_config->is_log_async() && !m_logger->set_async()) {
+        LOG_ERROR("set async log failed!");
+        return false;
+    }
+
     m_logger->set_worker_index(0);
     m_logger->set_process_type(true);
 
@@ -127,6 +141,65 @@ bool Manager::load_sys_config(const std::string& config_path) {
     return true;
 }
 
+bool Manager::load_reuseport_fds() {
+    if (!m_config->is_reuseport() || !m_config->is_reuseport_cbpf() ||
+        m_config->gate_host().empty()) {
+        return true;
+    }
+
+    /* the cbpf program returns an index of the reuseport group, the index is
+     * the order in which the sockets joined the group, so the sockets are created
+     * here in the workers' order. manager closes its copy once the worker is forked,
+     * so a dead worker's socket leaves the group, and the kernel steers its new
+     * connections to the rest (hash) instead of an accept queue nobody reads. */
+    auto cpus = m_config->worker_cpus();
+    auto worker_cnt = m_config->worker_cnt();
+    if (!m_config->is_cpu_affinity() || (int)cpus.size() < worker_cnt) {
+        LOG_WARN("cpu affinity is not set for all workers, reuseport cbpf is disabled!");
+        return true;
+    }
+    cpus.resize(worker_cnt);
+
+    char err[ANET_ERR_LEN];
+    auto host = m_config->gate_host().c_str();
+    auto port = m_config->gate_port();
+
+    for (int i = 0; i < worker_cnt; i++) {
+        auto fd = anet_tcp_server(err, host, port, TCP_BACK_LOG, true);
+        if (fd == -1) {
+            LOG_ERROR("bind tcp ipv4 failed! %s", err);
+            close_reuseport_fds();
+            return false;
+        }
+        m_reuseport_fds.push_back(fd);
+
+        if (anet_no_block(err, fd) != ANET_OK) {
+            LOG_ERROR("set socket no block failed! fd: %d, errstr: %s", fd, err);
+            close_reuseport_fds();
+            return false;
+        }
+    }
+
+    if (anet_attach_reuseport_cbpf(err, m_reuseport_fds[0], cpus.data(), cpus.size()) != ANET_OK) {
+        LOG_ERROR("attach reuseport cbpf failed! %s", err);
+        close_reuseport_fds();
+        return false;
+    }
+
+    LOG_INFO("reuseport cbpf, listen to port, %s:%d, fds: %lu",
+             host, port, m_reuseport_fds.size());
+    return true;
+}
+
+void Manager::close_reuseport_fds(int keep_fd) {
+    for (auto fd : m_reuseport_fds) {
+        if (fd != -1 && fd != keep_fd) {
+            close(fd);
+        }
+    }
+    m_reuseport_fds.clear();
+}
+
 bool Manager::create_worker(int worker_index) {
     int pid, data_fds[2], ctrl_fds[2];
     auto config_path = m_config->config_path();
@@ -151,12 +224,19 @@ bool Manager::create_worker(int worker_index) {
         close(ctrl_fds[0]);
         close(data_fds[0]);
 
+        /* keep the worker's own gate fd in reuseport group. */
+        int gate_fd = -1;
+        if ((int)m_reuseport_fds.size() >= worker_index) {
+            gate_fd = m_reuseport_fds[worker_index - 1];
+        }
+        close_reuseport_fds(gate_fd);
+
         fd_t fctrl;
         fctrl.fd = ctrl_fds[1];
         fd_t fdata;
         fdata.fd = data_fds[1];
 
-        worker_info_t info{0, worker_index, fctrl, fdata, work_path};
+        worker_info_t info{0, worker_index, fctrl, fdata, work_path, Payload(), 0, gate_fd};
         Worker worker(worker_name);
         if (!worker.init(&info, config_path)) {
             _exit(EXIT_CHILD_INIT_FAIL);
@@ -168,6 +248,13 @@ bool Manager::create_worker(int worker_index) {
         close(ctrl_fds[1]);
         close(data_fds[1]);
 
+        /* the worker owns its gate fd now. */
+        if ((int)m_reuseport_fds.size() >= worker_index &&
+            m_reuseport_fds[worker_index - 1] != -1) {
+            close(m_reuseport_fds[worker_index - 1]);
+            m_reuseport_fds[worker_index - 1] = -1;
+        }
+
         fd_t fctrl;
         fctrl.fd = ctrl_fds[0];
 
@@ -274,9 +361,28 @@ void Manager::signal_handler(int sig) {
 }
 
 void Manager::signal_handler_event(int sig) {
+    /* async-signal-safe calls only, the interrupted code may hold the logger's lock. */
     if (sig == SIGCHLD) {
-        int pid, status, ret;
-        /* use 'while' for recovering as many signals as possible each time. */
+        m_child_signal = 1;
+    } else if (sig == SIGINT || sig == SIGTERM) {
+        m_stop_signal = sig;
+    } else {
+        /* crash, kill(2) the workers without allocating or locking,
+         * write out the buffered logs if the lock can be taken soon. */
+        close_workers();
+        if (m_logger != nullptr) {
+            m_logger->flush(true);
+        }
+        _exit(sig);
+    }
+}
+
+void Manager::handle_signals() {
+    if (m_child_signal) {
+        m_child_signal = 0;
+
+        int pid, status, ret = 0;
+        /* use 'while' for recovering as many children as possible each time. */
         while ((pid = waitpid(-1, &status, WNOHANG)) > 0) {
             if (WIFEXITED(status)) {
                 ret = WEXITSTATUS(status);
@@ -286,10 +392,13 @@ void Manager::signal_handler_event(int sig) {
                 ret = WSTOPSIG(status);
             }
             LOG_CRIT("child terminated! pid: %d, signal %d, error: %d, ret: %d!",
-                     pid, sig, status, ret);
+                     pid, SIGCHLD, status, ret);
             // restart_worker(pid);
         }
-    } else {
+    }
+
+    if (m_stop_signal) {
+        int sig = m_stop_signal;
         LOG_CRIT("%s terminated by signal %d!",
                  m_config->server_name().c_str(), sig);
 
@@ -300,6 +409,9 @@ void Manager::signal_handler_event(int sig) {
         }
 
         sleep(1);
+        if (m_logger != nullptr) {
+            m_logger->flush();
+        }
         exit(sig);
     }
 }
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <signal.h>
+
 #include "network.h"
 #include "timer.h"
 
@@ -18,6 +20,8 @@ class Manager : CoTimer {
     bool load_logger();
     bool load_network();
     bool load_sys_config(const std::string& config_path);
+    bool load_reuseport_fds(); /* gate's reuseport group, steered by cpu. */
+    void close_reuseport_fds(int keep_fd = -1);
 
     void create_workers();                /* fork children. */
     bool create_worker(int worker_index); /* creates the specified index process. */
@@ -26,9 +30,10 @@ class Manager : CoTimer {
     void close_workers();                 /* notify workers to close. */
     virtual void on_repeat_timer() override;
 
-    /* signals. */
+    /* signals, the handler only sets the flags, they are handled in the timer. */
     void load_signals();
     void signal_handler_event(int sig);
+    void handle_signals();
     static void signal_handler(int sig);
 
    private:
@@ -36,7 +41,10 @@ class Manager : CoTimer {
     std::shared_ptr<Network> m_net = nullptr;      /* net work. */
     std::shared_ptr<SysConfig> m_config = nullptr; /* system config data. */
     static void* m_signal_user_data;
+    static volatile sig_atomic_t m_child_signal; /* SIGCHLD arrived. */
+    static volatile sig_atomic_t m_stop_signal;  /* SIGINT/SIGTERM arrived, 0: none. */
     std::queue<int> m_restart_workers; /* workers waiting to restart. restore worker's index. */
+    std::vector<int> m_reuseport_fds;  /* gate's listen fds not forked yet, index: worker_index - 1. */
 };
 
 }  // namespace kim
@@ -46,6 +46,9 @@ class Module : public Logger, public Net, public So {
         if (it == m_cmd_funcs.end()) {                                                               \
             return filter_request(req);                                                              \
         }                                                                                            \
+        if (!req->decode_body()) {                                                                   \
+            return net()->send_ack(req, ERR_PACKET_DECODE_FAILED, "decode msg body failed!");        \
+        }                                                                                            \
         return (this->*(it->second))(req);                                                           \
     }                                                                                                \
                                                                                                      \
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/wire_format_lite.h>
+
 #include "protobuf/proto/http.pb.h"
 #include "protobuf/proto/msg.pb.h"
 #include "server.h"
@@ -12,6 +15,9 @@ namespace kim {
     }                                   \
     return obj
 
+#define MSG_POOL_MAX_FREE 1024             /* max count of free msgs in pool. */
+#define MSG_POOL_MAX_DATA_LEN (64 * 1024)  /* don't recycle msg which holds big buffer. */
+
 class Msg {
    public:
     Msg() = default;
@@ -24,16 +30,166 @@ class Msg {
     const int fd() const { return m_ft.fd; }
     const bool is_http() const { return m_is_http; }
 
+    /* private codec's head route key, 0: not set. */
+    uint32_t route_key() const { return m_route_key; }
+    void set_route_key(uint32_t key) { m_route_key = key; }
+
+    /* pass-through: codec keeps the undecoded body bytes instead of parsing them,
+     * so the msg can be relayed without decoding/encoding its body.
+     * decode_body() decodes the raw bytes and turns the raw mode off, it fails if
+     * they are not a valid body (the msg keeps raw, and body() is empty then). */
+    bool is_raw() const { return m_is_raw; }
+    void set_raw(bool raw) { m_is_raw = raw; }
+    const std::string& raw_body() const { return m_raw_body; }
+    void set_raw_body(const char* data, size_t len) { m_raw_body.assign(data, len); }
+
+    bool decode_body() {
+        if (!m_is_raw) {
+            return true;
+        }
+        if (m_msg_body == nullptr) {
+            m_msg_body = std::make_shared<MsgBody>();
+        }
+        if (!m_msg_body->ParseFromString(m_raw_body)) {
+            m_msg_body->Clear();
+            return false;
+        }
+        m_is_raw = false;
+        m_raw_body.clear();
+        return true;
+    }
+
+    /* MsgBody.data, only this field is decoded in raw mode.
+     * the whole body is scanned, the last data field wins as protobuf's parser does. */
+    bool body_data(std::string& data) {
+        using google::protobuf::internal::WireFormatLite;
+        if (!m_is_raw) {
+            data = body()->data();
+            return true;
+        }
+
+        data.clear();
+        google::protobuf::io::CodedInputStream in(
+            (const uint8_t*)m_raw_body.data(), (int)m_raw_body.size());
+        for (;;) {
+            uint32_t tag = in.ReadTag();
+            if (tag == 0) {
+                return in.ConsumedEntireMessage();
+            }
+            if (WireFormatLite::GetTagFieldNumber(tag) == MsgBody::kDataFieldNumber &&
+                WireFormatLite::GetTagWireType(tag) == WireFormatLite::WIRETYPE_LENGTH_DELIMITED) {
+                if (!WireFormatLite::ReadBytes(&in, &data)) {
+                    return false;
+                }
+                continue;
+            }
+            if (!WireFormatLite::SkipField(&in, tag)) {
+                return false;
+            }
+        }
+    }
+
     std::shared_ptr<MsgHead> head() { RETURN_CHECK_OBJ(m_msg_head, MsgHead); }
-    std::shared_ptr<MsgBody> body() { RETURN_CHECK_OBJ(m_msg_body, MsgBody); }
+    std::shared_ptr<MsgBody> body() {
+        if (m_is_raw) {
+            decode_body();
+        }
+        RETURN_CHECK_OBJ(m_msg_body, MsgBody);
+    }
     std::shared_ptr<HttpMsg> http_msg() { RETURN_CHECK_OBJ(m_http_msg, HttpMsg); }
 
+    /* for pool, protobuf's Clear() keeps the objects and their string's memory. */
+    void reset(const fd_t& ft, bool is_http = false) {
+        m_ft = ft;
+        m_is_http = is_http;
+        m_route_key = 0;
+        m_is_raw = false;
+        m_raw_body.clear();
+        if (m_msg_head != nullptr) m_msg_head->Clear();
+        if (m_msg_body != nullptr) m_msg_body->Clear();
+        if (m_http_msg != nullptr) m_http_msg->Clear();
+    }
+
+    bool is_recyclable() {
+        if (m_msg_head.use_count() > 1 || m_msg_body.use_count() > 1 || m_http_msg.use_count() > 1) {
+            return false; /* still shared by others. */
+        }
+        if (m_msg_body != nullptr &&
+            m_msg_body->data().capacity() + m_msg_body->add_on().capacity() > MSG_POOL_MAX_DATA_LEN) {
+            return false;
+        }
+        if (m_raw_body.capacity() > MSG_POOL_MAX_DATA_LEN) {
+            return false;
+        }
+        return (m_http_msg == nullptr || m_http_msg->ByteSizeLong() <= MSG_POOL_MAX_DATA_LEN);
+    }
+
    private:
     fd_t m_ft;
     bool m_is_http = false;
+    uint32_t m_route_key = 0;
+    bool m_is_raw = false;
+    std::string m_raw_body;                         // undecoded body for pass-through.
     std::shared_ptr<MsgHead> m_msg_head = nullptr;  // protobuf msg head.
     std::shared_ptr<MsgBody> m_msg_body = nullptr;  // protobuf msg body.
     std::shared_ptr<HttpMsg> m_http_msg = nullptr;  // http msg.
 };
 
+/* free list of msgs, one per process.
+ * msgs are recycled when the last owner releases them. */
+class MsgPool : public std::enable_shared_from_this<MsgPool> {
+   public:
+    MsgPool(size_t max_free = MSG_POOL_MAX_FREE) : m_max_free(max_free) {}
+    virtual ~MsgPool() {
+        for (auto msg : m_free_msgs) {
+            delete msg;
+        }
+    }
+
+    MsgPool(const MsgPool&) = delete;
+    MsgPool& operator=(const MsgPool&) = delete;
+
+    std::shared_ptr<Msg> alloc(const fd_t& ft = fd_t(), bool is_http = false) {
+        Msg* msg = nullptr;
+        if (!m_free_msgs.empty()) {
+            msg = m_free_msgs.back();
+            m_free_msgs.pop_back();
+            msg->reset(ft, is_http);
+            m_hit_cnt++;
+        } else {
+            msg = new Msg(ft, is_http);
+            m_miss_cnt++;
+        }
+
+        std::weak_ptr<MsgPool> pool = shared_from_this();
+        return std::shared_ptr<Msg>(msg, [pool](Msg* m) {
+            auto p = pool.lock();
+            if (p != nullptr) {
+                p->recycle(m);
+            } else {
+                delete m;
+            }
+        });
+    }
+
+    size_t free_cnt() { return m_free_msgs.size(); }
+    uint64_t hit_cnt() { return m_hit_cnt; }
+    uint64_t miss_cnt() { return m_miss_cnt; }
+
+   private:
+    void recycle(Msg* msg) {
+        if (m_free_msgs.size() >= m_max_free || !msg->is_recyclable()) {
+            delete msg;
+            return;
+        }
+        m_free_msgs.push_back(msg);
+    }
+
+   private:
+    size_t m_max_free = MSG_POOL_MAX_FREE;
+    std::vector<Msg*> m_free_msgs;
+    uint64_t m_hit_cnt = 0;
+    uint64_t m_miss_cnt = 0;
+};
+
 };  // namespace kim
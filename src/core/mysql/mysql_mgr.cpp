@@ -24,7 +24,9 @@ int MysqlMgr::sql_write(const std::string& node, const std::string& sql) {
         LOG_ERROR("invalid db exec params!");
         return ERR_INVALID_PARAMS;
     }
-    return send_task(node, sql, false);
+    int ret = send_task(node, sql, false);
+    m_write_seqs[node]++;
+    return ret;
 }
 
 int MysqlMgr::sql_read(const std::string& node, const std::string& sql, std::shared_ptr<VecMapRow> rows) {
@@ -32,7 +34,54 @@ int MysqlMgr::sql_read(const std::string& node, const std::string& sql, std::sha
         LOG_ERROR("invalid db query params!");
         return ERR_INVALID_PARAMS;
     }
-    return send_task(node, sql, true, rows);
+
+    std::string key(node);
+    key.push_back('\0');
+    key.append(sql);
+
+    uint64_t write_seq = m_write_seqs[node];
+    auto it = m_flights.find(key);
+    if (it != m_flights.end() && it->second->write_seq == write_seq) {
+        /* 相同的读请求正在处理，等待它的结果。 */
+        auto fl = it->second;
+        fl->followers.push_back(co_self());
+        co_yield_ct();
+
+        if (fl->ret == ERR_OK && rows != nullptr) {
+            rows->insert(rows->end(), fl->rows->begin(), fl->rows->end());
+        }
+        return fl->ret;
+    }
+
+    /* 正在处理的读请求可能读不到之后完成的写入，由本请求替代它被后来者合并。 */
+    auto fl = std::make_shared<flight_t>();
+    fl->rows = std::make_shared<VecMapRow>();
+    fl->write_seq = write_seq;
+    m_flights[key] = fl;
+
+    fl->ret = send_task(node, sql, true, fl->rows);
+    it = m_flights.find(key);
+    if (it != m_flights.end() && it->second == fl) {
+        m_flights.erase(it);
+    }
+
+    /* 唤醒等待者拷贝结果，最后才把结果交给自己。 */
+    if (!fl->followers.empty()) {
+        LOG_TRACE("sql read coalesced! node: %s, followers: %lu",
+                  node.c_str(), fl->followers.size());
+        for (auto co : fl->followers) {
+            co_resume(co);
+        }
+    }
+
+    if (fl->ret == ERR_OK && rows != nullptr) {
+        if (rows->empty()) {
+            rows->swap(*fl->rows);
+        } else {
+            rows->insert(rows->end(), fl->rows->begin(), fl->rows->end());
+        }
+    }
+    return fl->ret;
 }
 
 int MysqlMgr::send_task(const std::string& node, const std::string& sql,
@@ -55,7 +104,7 @@ int MysqlMgr::send_task(const std::string& node, const std::string& sql,
     task->rows = rows;
     task->is_read = is_read;
     task->user_co = co_self();
-    task->active_time = mstime();
+    task->active_time = co_tick_ms();
 
     /* 先将任务放进任务分配器。 */
     md->tasks.push(task);
@@ -143,7 +192,8 @@ void MysqlMgr::on_handle_task(std::shared_ptr<co_mgr_data_t> md, std::shared_ptr
         cd->tasks.pop();
 
         m_cur_handle_cnt++;
-        cd->active_time = mstime();
+        /* precise clock for slowlog, the loop clock lags behind while handlers are running. */
+        cd->active_time = co_tick_ms_precise();
 
         /* 带处理的任务，超时了，通知用户任务处理超时。 */
         if (cd->active_time > task->active_time + TASK_TIME_OUT) {
@@ -160,7 +210,7 @@ void MysqlMgr::on_handle_task(std::shared_ptr<co_mgr_data_t> md, std::shared_ptr
             task->ret = cd->c->sql_write(task->sql);
         }
 
-        auto spend = mstime() - cd->active_time;
+        auto spend = co_tick_ms_precise() - cd->active_time;
         if (spend > m_slowlog_log_slower_than) {
             LOG_WARN("slowlog - sql spend time: %llu, sql: %s", spend, task->sql.c_str());
         }
@@ -261,7 +311,7 @@ void MysqlMgr::on_repeat_timer() {
             m_old_handle_cnt = m_cur_handle_cnt;
         }
 
-        auto now = mstime();
+        auto now = co_tick_ms();
 
         /* recover free connections. */
         for (auto it : m_coroutines) {
@@ -14,12 +14,20 @@ class MysqlMgr : public Logger, public TimerCron {
         stCoRoutine_t* user_co = nullptr;          /* 用户协程。*/
         bool is_read = false;                      /* 读写操作，是否为读操作。*/
         std::string sql;                           /* sql 命令字符串。*/
-        long long active_time = 0;                 /* 任务进入处理队列时间。*/
+        uint64_t active_time = 0;                  /* 任务进入处理队列时间。*/
         int ret = 0;                               /* sql 任务处理错误码。*/
         std::string errstr;                        /* sql 任务处理错误码字符串。*/
         std::shared_ptr<VecMapRow> rows = nullptr; /* 读数据库的数据集合。*/
     } task_t;
 
+    /* 合并读请求：相同的读请求正在处理时，后来者等待它的结果，不再重复查询。*/
+    typedef struct flight_s {
+        int ret = 0;                               /* 读请求处理错误码。*/
+        uint64_t write_seq = 0;                    /* 读请求发出时，节点已完成的写请求数。*/
+        std::shared_ptr<VecMapRow> rows = nullptr; /* 读数据库的数据集合，由等待者拷贝。*/
+        std::vector<stCoRoutine_t*> followers;     /* 等待结果的用户协程。*/
+    } flight_t;
+
     struct co_mgr_data_s;
 
     /* 任务处理器。*/
@@ -29,7 +37,7 @@ class MysqlMgr : public Logger, public TimerCron {
         stCoRoutine_t* co = nullptr;               /* 协程结构指针。*/
         std::shared_ptr<MysqlConn> c = nullptr;    /* 数据库链接。*/
         std::queue<std::shared_ptr<task_t>> tasks; /* 待处理 sql 任务。*/
-        long long active_time = 0;                 /* 处理器处理当前任务时间，用来捕捉慢日志。*/
+        uint64_t active_time = 0;                  /* 处理器处理当前任务时间，用来捕捉慢日志。*/
     } co_data_t;
 
     /* 任务分配器。*/
@@ -76,6 +84,9 @@ class MysqlMgr : public Logger, public TimerCron {
      * @param rows: query result.
      *
      * @return error.h / enum E_ERROR.
+     *
+     * 同一节点相同 sql 的并发读请求，只查询一次数据库，结果拷贝给每个请求者。
+     * 节点有写请求完成后，不再合并到它之前发出的读请求，保证协程能读到自己写入的数据。
      */
     int sql_read(const std::string& node, const std::string& sql, std::shared_ptr<VecMapRow> rows);
 
@@ -119,12 +130,16 @@ class MysqlMgr : public Logger, public TimerCron {
 
     int m_old_handle_cnt = 0;
     int m_cur_handle_cnt = 0;
-    long long m_slowlog_log_slower_than = 0; /* 慢日志时间，单位为毫秒。*/
+    uint64_t m_slowlog_log_slower_than = 0;  /* 慢日志时间，单位为毫秒。*/
 
     /* key: node, valude: 数据库信息。*/
     std::unordered_map<std::string, std::shared_ptr<db_info_t>> m_dbs;
     /* key: node, value: 任务分配器。*/
     std::unordered_map<std::string, std::shared_ptr<co_mgr_data_t>> m_coroutines;
+    /* key: node + '\0' + sql, value: 正在处理的读请求。*/
+    std::unordered_map<std::string, std::shared_ptr<flight_t>> m_flights;
+    /* key: node, valude: 已完成的写请求数，在此之前发出的读请求不再被合并。*/
+    std::unordered_map<std::string, uint64_t> m_write_seqs;
 };
 
 }  // namespace kim
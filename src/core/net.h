@@ -1,6 +1,7 @@
 #pragma once
 
 #include "error.h"
+#include "msg.h"
 #include "mysql/mysql_mgr.h"
 #include "protobuf/proto/http.pb.h"
 #include "protobuf/proto/msg.pb.h"
@@ -15,7 +16,6 @@ class SysCmd;
 class RedisMgr;
 class ZkClient;
 class Coroutines;
-class Msg;
 class Connection;
 class SessionMgr;
 
@@ -25,7 +25,9 @@ class INet : public std::enable_shared_from_this<INet> {
     virtual ~INet() {}
 
     virtual uint64_t new_seq() { return 0; }
-    virtual uint64_t now(bool force = false) { return mstime(); }
+    virtual std::shared_ptr<Msg> new_msg(const fd_t& ft = fd_t()) { return std::make_shared<Msg>(ft); }
+    /* loop clock (monotonic ms), force: read the precise clock. */
+    virtual uint64_t now(bool force = false) { return force ? co_tick_ms_precise() : co_tick_ms(); }
 
     virtual CJsonObject* config() { return nullptr; }
     virtual std::shared_ptr<MysqlMgr> mysql_mgr() { return nullptr; }
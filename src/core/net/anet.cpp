@@ -3,6 +3,7 @@
 #include <arpa/inet.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <linux/filter.h>
 #include <netdb.h>
 #include <netinet/in.h>
 #include <netinet/tcp.h>
@@ -244,6 +245,39 @@ int anet_set_tcp_reuseport(char *err, int fd) {
     return ANET_OK;
 }
 
+int anet_attach_reuseport_cbpf(char *err, int fd, const int *cpus, int cnt) {
+#if defined(SO_ATTACH_REUSEPORT_CBPF)
+    if (cpus == nullptr || cnt <= 0 || cnt > 255) {
+        anet_set_error(err, "invalid reuseport cpus cnt: %d", cnt);
+        return ANET_ERR;
+    }
+
+    /* A = cpu; if (A == cpus[i]) return i; ...
+     * return an invalid index to fall back to the kernel's hash. */
+    struct sock_filter code[2 * 255 + 2];
+    int n = 0;
+    code[n++] = BPF_STMT(BPF_LD | BPF_W | BPF_ABS, (uint32_t)(SKF_AD_OFF + SKF_AD_CPU));
+    for (int i = 0; i < cnt; i++) {
+        code[n++] = BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, (uint32_t)cpus[i], 0, 1);
+        code[n++] = BPF_STMT(BPF_RET | BPF_K, (uint32_t)i);
+    }
+    code[n++] = BPF_STMT(BPF_RET | BPF_K, 0xffffffff);
+
+    struct sock_fprog prog;
+    prog.len = n;
+    prog.filter = code;
+
+    if (setsockopt(fd, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &prog, sizeof(prog)) == -1) {
+        anet_set_error(err, "setsockopt SO_ATTACH_REUSEPORT_CBPF: %s", strerror(errno));
+        return ANET_ERR;
+    }
+    return ANET_OK;
+#else
+    anet_set_error(err, "SO_ATTACH_REUSEPORT_CBPF is not supported!");
+    return ANET_ERR;
+#endif
+}
+
 int anet_tcp_connect(char *err, const char *addr, int port, bool is_block,
                      struct sockaddr *saddr, size_t *saddrlen) {
     int s = ANET_ERR, rv;
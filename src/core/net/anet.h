@@ -26,6 +26,9 @@ int anet_tcp_accept(char *err, int s, char *ip, size_t ip_len, int *port, int *f
 int anet_keep_alive(char *err, int fd, int interval);
 int anet_set_tcp_no_delay(char *err, int fd, int val);
 int anet_set_tcp_reuseport(char *err, int fd);
+/* steer a new connection to the reuseport socket whose index matches the cpu
+ * which handles its packets: cpus[i] --> socket i in the reuseport group. */
+int anet_attach_reuseport_cbpf(char *err, int fd, const int *cpus, int cnt);
 
 int anet_tcp_connect(
     char *err, const char *host, int port,
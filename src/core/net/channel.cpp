@@ -4,6 +4,7 @@
 
 #include <string.h>
 #include <sys/socket.h>
+#include <unistd.h>
 
 namespace kim {
 
@@ -153,4 +154,140 @@ int read_channel(int fd, channel_t* ch, size_t size, std::shared_ptr<Log> logger
     return 0;
 }
 
+int write_channels(int fd, channel_t* chs, int cnt, std::shared_ptr<Log> logger) {
+    LOG_TRACE("write to channel, fd: %d, cnt: %d", fd, cnt);
+    ssize_t n;
+    struct iovec iov[1];
+    struct msghdr msg;
+    int err = 0;
+
+    union {
+        struct cmsghdr cm;
+        char space[CMSG_SPACE(sizeof(int) * CHANNEL_MAX_BATCH)];
+    } cmsg;
+
+    if (cnt <= 0 || cnt > CHANNEL_MAX_BATCH) {
+        LOG_ERROR("invalid channel cnt: %d", cnt);
+        return -1;
+    }
+
+    memset(&msg, 0, sizeof(msg));
+    memset(&cmsg, 0, sizeof(cmsg));
+
+    msg.msg_control = (caddr_t)&cmsg;
+    msg.msg_controllen = CMSG_SPACE(sizeof(int) * cnt);
+
+    cmsg.cm.cmsg_len = CMSG_LEN(sizeof(int) * cnt);
+    cmsg.cm.cmsg_level = SOL_SOCKET;
+    cmsg.cm.cmsg_type = SCM_RIGHTS;
+
+    int* fds = (int*)CMSG_DATA(&cmsg.cm);
+    for (int i = 0; i < cnt; i++) {
+        if (chs[i].fd == -1) {
+            LOG_ERROR("invalid fd in channel batch, index: %d", i);
+            return -1;
+        }
+        fds[i] = chs[i].fd;
+    }
+
+    iov[0].iov_base = (char*)chs;
+    iov[0].iov_len = sizeof(channel_t) * cnt;
+
+    msg.msg_iov = iov;
+    msg.msg_iovlen = 1;
+
+    n = sendmsg(fd, &msg, 0);
+
+    if (n == -1) {
+        err = errno;
+        if (err == EAGAIN) {
+            LOG_DEBUG("wait to sendmsg again! err: %d, error: %s",
+                      errno, strerror(errno));
+            return err;
+        }
+        LOG_ERROR("sendmsg() failed! err: %d, error: %s",
+                  errno, strerror(errno));
+        return -1;
+    }
+
+    if ((size_t)n != sizeof(channel_t) * cnt) {
+        LOG_ERROR("sendmsg() partial write! len: %d, cnt: %d", (int)n, cnt);
+        return -1;
+    }
+    return 0;
+}
+
+int read_channels(int fd, channel_t* chs, int max, int* cnt, std::shared_ptr<Log> logger) {
+    ssize_t n;
+    int err = 0, nfds = 0, nchs = 0;
+    int fds[CHANNEL_MAX_BATCH];
+    struct iovec iov[1];
+    struct msghdr msg;
+    struct cmsghdr* cm;
+
+    union {
+        struct cmsghdr cm;
+        char space[CMSG_SPACE(sizeof(int) * CHANNEL_MAX_BATCH)];
+    } cmsg;
+
+    if (max > CHANNEL_MAX_BATCH) {
+        max = CHANNEL_MAX_BATCH;
+    }
+
+    memset(&msg, 0, sizeof(msg));
+
+    iov[0].iov_base = (char*)chs;
+    iov[0].iov_len = sizeof(channel_t) * max;
+
+    msg.msg_iov = iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = (caddr_t)&cmsg;
+    msg.msg_controllen = sizeof(cmsg);
+
+    n = recvmsg(fd, &msg, 0);
+
+    if (n == -1) {
+        err = errno;
+        if (err == EAGAIN) {
+            return err;
+        }
+        LOG_ERROR("recvmsg() failed!");
+        return -1;
+    }
+
+    if (n == 0) {
+        LOG_ERROR("rrecvmsg() returned zero! err: %d, error: %s",
+                  errno, strerror(errno));
+        return -1;
+    }
+
+    /* every batch carries its fds, so the stream socket doesn't merge batches. */
+    for (cm = CMSG_FIRSTHDR(&msg); cm != NULL; cm = CMSG_NXTHDR(&msg, cm)) {
+        if (cm->cmsg_level != SOL_SOCKET || cm->cmsg_type != SCM_RIGHTS) {
+            continue;
+        }
+        int len = (cm->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+        for (int i = 0; i < len && nfds < CHANNEL_MAX_BATCH; i++) {
+            memcpy(&fds[nfds++], CMSG_DATA(cm) + i * sizeof(int), sizeof(int));
+        }
+    }
+
+    nchs = n / sizeof(channel_t);
+    if ((size_t)n % sizeof(channel_t) != 0 || nchs != nfds ||
+        (msg.msg_flags & (MSG_TRUNC | MSG_CTRUNC))) {
+        LOG_ERROR("recvmsg() returned invalid data! len: %d, fds: %d, flags: %d",
+                  (int)n, nfds, msg.msg_flags);
+        for (int i = 0; i < nfds; i++) {
+            close(fds[i]);
+        }
+        return -1;
+    }
+
+    for (int i = 0; i < nchs; i++) {
+        chs[i].fd = fds[i];
+    }
+    *cnt = nchs;
+    return 0;
+}
+
 }  // namespace kim
\ No newline at end of file
@@ -18,9 +18,16 @@ typedef struct channel_s {
     int is_system;
 } channel_t;
 
+#define CHANNEL_MAX_BATCH 64 /* max fds transfered by one sendmsg. */
+
 int write_channel(int fd, channel_t* ch, size_t size, std::shared_ptr<Log> logger = nullptr);
 int read_channel(int fd, channel_t* ch, size_t size, std::shared_ptr<Log> logger = nullptr);
 
+/* transfer a batch of fds with their channel_t in one sendmsg/recvmsg.
+ * a single write_channel() is read as a batch of one. */
+int write_channels(int fd, channel_t* chs, int cnt, std::shared_ptr<Log> logger = nullptr);
+int read_channels(int fd, channel_t* chs, int max, int* cnt, std::shared_ptr<Log> logger = nullptr);
+
 }  // namespace kim
 
 #ifdef __cplusplus
@@ -14,7 +14,6 @@
 namespace kim {
 
 Network::Network(std::shared_ptr<Log> logger, TYPE type) : Logger(logger), m_type(type) {
-    m_now_time = mstime();
 }
 
 Network::~Network() {
@@ -153,7 +152,7 @@ bool Network::init_manager_channel(fd_t& fctrl, fd_t& fdata) {
 }
 
 /* worker. */
-bool Network::create_w(std::shared_ptr<SysConfig> config, int ctrl_fd, int data_fd, int index) {
+bool Network::create_w(std::shared_ptr<SysConfig> config, int ctrl_fd, int data_fd, int index, int gate_fd) {
     if (config == nullptr) {
         return false;
     }
@@ -231,7 +230,9 @@ bool Network::create_w(std::shared_ptr<SysConfig> config, int ctrl_fd, int data_
     /* gate listen. */
     if (config->is_reuseport()) {
         if (!config->gate_host().empty()) {
-            auto fd = listen_to_port(config->gate_host().c_str(), config->gate_port(), true);
+            auto fd = (gate_fd != -1)
+                          ? gate_fd
+                          : listen_to_port(config->gate_host().c_str(), config->gate_port(), true);
             if (fd == -1) {
                 LOG_ERROR("listen to gate failed! %s:%d",
                           config->gate_host().c_str(), config->gate_port());
@@ -287,13 +288,14 @@ bool Network::ensure_files_limit() {
     }
 
     m_max_clients = file_limit;
+    m_conns.reserve(m_max_clients + CONFIG_MIN_RESERVED_FDS);
     return true;
 }
 
 void Network::run() {
     LOG_INFO("network run: %d", (int)m_type);
     if (m_coroutines != nullptr) {
-        m_coroutines->run();
+        m_coroutines->run([this]() { flush_dirty_conns(); });
     }
 }
 
@@ -321,8 +323,6 @@ int Network::listen_to_port(const char* host, int port, bool is_reuseport) {
 }
 
 void Network::on_repeat_timer() {
-    m_now_time = mstime();
-
     if (is_manager()) {
         if (m_zk_cli != nullptr) {
             m_zk_cli->on_timer();
@@ -332,17 +332,22 @@ void Network::on_repeat_timer() {
         }
     } else {
         run_with_period(1000) {
-            /* send payload info to manager. */
-            // report_payload_to_manager();
+            /* send payload info to manager, for choosing worker. */
+            report_payload_to_manager();
         }
     }
 
-#if !defined(__APPLE__)
-    /* glibc maybe memory leak, so release the cache memory in timer. */
     run_with_period(60 * 1000) {
+        LOG_DEBUG("msg pool, free: %lu, hit: %llu, miss: %llu",
+                  m_msg_pool->free_cnt(), m_msg_pool->hit_cnt(), m_msg_pool->miss_cnt());
+        LOG_DEBUG("buffer pool, %s", BufferPool::instance()->stats().c_str());
+        /* the pool is never destroyed, release its cached blocks here. */
+        BufferPool::instance()->trim();
+#if !defined(__APPLE__)
+        /* glibc maybe memory leak, so release the cache memory in timer. */
         malloc_trim(0);
-    }
 #endif
+    }
 
     if (m_mysql_mgr != nullptr) {
         m_mysql_mgr->on_timer();
@@ -399,7 +404,7 @@ bool Network::report_payload_to_zookeeper() {
     manager_pl->set_read_bytes(read_bytes + m_payload.read_bytes());
     manager_pl->set_write_cnt(write_cnt + m_payload.write_cnt());
     manager_pl->set_write_bytes(write_bytes + m_payload.write_bytes());
-    manager_pl->set_create_time(now());
+    manager_pl->set_create_time(mstime());
 
     m_payload.Clear();
 
@@ -424,7 +429,9 @@ bool Network::report_payload_to_manager() {
     m_payload.set_worker_index(worker_index());
     m_payload.set_cmd_cnt(0);
     m_payload.set_conn_cnt(m_conns.size() + m_node_conns.size());
-    m_payload.set_create_time(now());
+    m_payload.set_co_cnt(m_coroutines->work_co_cnt());
+    m_payload.set_recv_fd_cnt(m_recv_fd_cnt);
+    m_payload.set_create_time(mstime());
 
     if (!m_sys_cmd->send_payload_to_manager(m_payload)) {
         m_payload.Clear();
@@ -478,48 +485,82 @@ void Network::on_handle_accept_nodes_conn() {
 void Network::on_handle_accept_gate_conn() {
     co_enable_hook_sys();
 
-    channel_t ch;
     char ip[NET_IP_STR_LEN] = {0};
     int port, family, channel_fd;
 
+    /* accepted fds wait to be transfered, key: worker's channel fd. */
+    std::unordered_map<int, std::vector<channel_t>> batches;
+    uint64_t batch_time = 0; /* ms, when the batches were handed off last time. */
+    auto flush_batches = [this, &batches, &batch_time]() {
+        for (auto& it : batches) {
+            transfer_fds(it.first, it.second);
+        }
+        batches.clear();
+        batch_time = now(true);
+    };
+
+    /* io_uring: one multishot accept, peer's address is not fetched. */
+    stCoUringAccept_t* acc = m_is_io_uring ? co_uring_accept_alloc(m_gate_fd) : nullptr;
+    if (acc != nullptr) {
+        struct sockaddr_storage sa;
+        socklen_t salen = sizeof(sa);
+        family = (getsockname(m_gate_fd, (struct sockaddr*)&sa, &salen) == 0) ? sa.ss_family : AF_INET;
+    }
+
     for (;;) {
-        auto fd = anet_tcp_accept(m_errstr, m_gate_fd, ip, sizeof(ip), &port, &family);
+        int fd;
+        if (acc != nullptr) {
+            fd = co_uring_accept(acc);
+            if (fd == ANET_ERR && errno != EAGAIN) {
+                snprintf(m_errstr, sizeof(m_errstr), "uring accept: %s", strerror(errno));
+            }
+        } else {
+            fd = anet_tcp_accept(m_errstr, m_gate_fd, ip, sizeof(ip), &port, &family);
+        }
+
         if (fd == ANET_ERR) {
             if (errno != EWOULDBLOCK) {
                 LOG_WARN("accepting client connection: %s", m_errstr);
             }
-            co_sleep(10000, m_gate_fd, POLLIN);
+            /* accept queue is drained, hand off the batches. */
+            if (!batches.empty()) {
+                flush_batches();
+                continue;
+            }
+            if (acc != nullptr) {
+                co_uring_accept_wait(acc, 10000);
+            } else {
+                co_sleep(10000, m_gate_fd, POLLIN);
+            }
             continue;
         }
 
-        LOG_INFO("accepted client: %s:%d, fd: %d", ip, port, fd);
+        if (acc != nullptr) {
+            LOG_INFO("accepted client, fd: %d", fd);
+        } else {
+            LOG_INFO("accepted client: %s:%d, fd: %d", ip, port, fd);
+        }
 
         if (!m_config->is_reuseport()) {
             /* transfer fd from manager to worker. */
             channel_fd = m_worker_data_mgr->get_next_worker_data_fd();
             if (channel_fd <= 0) {
                 LOG_ERROR("find next worker channel failed!");
+                close_fd(fd);
+                flush_batches();
                 break;
             }
 
-            ch = {fd, family, static_cast<int>(m_gate_codec), 0};
-
-            for (;;) {
-                auto err = write_channel(channel_fd, &ch, sizeof(channel_t), logger());
-                if (err == ERR_OK) {
-                    LOG_DEBUG("send client fd: %d to worker through channel fd %d", fd, channel_fd);
-                    break;
-                } else if (err == EAGAIN) {
-                    LOG_DEBUG("wait to write again, fd: %d, errno: %d", fd, err);
-                    co_sleep(1000, channel_fd, POLLOUT);
-                    continue;
-                } else {
-                    LOG_ERROR("write channel failed! errno: %d", err);
-                    break;
-                }
+            auto& chs = batches[channel_fd];
+            chs.push_back({fd, family, static_cast<int>(m_gate_codec), 0});
+            if (chs.size() >= CHANNEL_MAX_BATCH) {
+                transfer_fds(channel_fd, chs);
             }
 
-            close_fd(fd);
+            /* accept queue keeps busy, don't hold the fds longer than a tick. */
+            if (now(true) != batch_time) {
+                flush_batches();
+            }
         } else {
             if ((int)m_conns.size() > m_max_clients) {
                 LOG_WARN("max number of clients reached! %d", m_max_clients);
@@ -534,6 +575,8 @@ void Network::on_handle_accept_gate_conn() {
                 LOG_ERROR("add data fd read event failed, fd: %d", fd);
                 continue;
             }
+            c->set_client(true);
+            c->set_pass_through(m_is_gate_pass_through);
 
             LOG_INFO("accept client: fd: %d", fd);
 
@@ -549,17 +592,46 @@ void Network::on_handle_accept_gate_conn() {
             }
         }
     }
+
+    co_uring_accept_free(acc);
+}
+
+void Network::transfer_fds(int channel_fd, std::vector<channel_t>& chs) {
+    if (chs.empty()) {
+        return;
+    }
+
+    for (;;) {
+        auto err = write_channels(channel_fd, &chs[0], chs.size(), logger());
+        if (err == ERR_OK) {
+            LOG_DEBUG("send client fds: %lu to worker through channel fd %d", chs.size(), channel_fd);
+            break;
+        } else if (err == EAGAIN) {
+            LOG_DEBUG("wait to write again, channel fd: %d, errno: %d", channel_fd, err);
+            co_sleep(1000, channel_fd, POLLOUT);
+            continue;
+        } else {
+            LOG_ERROR("write channel failed! errno: %d", err);
+            break;
+        }
+    }
+
+    for (auto& ch : chs) {
+        close_fd(ch.fd);
+    }
+    chs.clear();
 }
 
 void Network::on_handle_read_transfer_fd(int fd) {
     co_enable_hook_sys();
     LOG_TRACE("on_handle_read_transfer_fd....");
 
-    channel_t ch;
+    int cnt = 0;
+    channel_t chs[CHANNEL_MAX_BATCH];
 
     for (;;) {
-        /* read fd from parent. */
-        auto err = read_channel(fd, &ch, sizeof(channel_t), logger());
+        /* read fds from parent. */
+        auto err = read_channels(fd, chs, CHANNEL_MAX_BATCH, &cnt, logger());
         if (err != 0) {
             if (err == EAGAIN) {
                 // LOG_TRACE("read channel again next time! channel fd: %d", fd);
@@ -571,44 +643,62 @@ void Network::on_handle_read_transfer_fd(int fd) {
             }
         }
 
-        if ((int)m_conns.size() > m_max_clients) {
-            LOG_WARN("max number of clients reached! %d", m_max_clients);
-            close_fd(ch.fd);
-            co_sleep(10);
-            continue;
+        m_recv_fd_cnt += cnt;
+        for (int i = 0; i < cnt; i++) {
+            add_transfer_conn(chs[i]);
         }
+    }
+}
 
-        auto codec = static_cast<Codec::TYPE>(ch.codec);
-        auto c = create_conn(ch.fd, codec);
-        if (c == nullptr) {
-            close_fd(ch.fd);
-            LOG_ERROR("add data fd read event failed, fd: %d", ch.fd);
-            continue;
-        }
+void Network::add_transfer_conn(const channel_t& ch) {
+    if ((int)m_conns.size() > m_max_clients) {
+        LOG_WARN("max number of clients reached! %d", m_max_clients);
+        close_fd(ch.fd);
+        return;
+    }
 
-        if (ch.is_system) {
-            c->set_system(true);
-        }
+    auto codec = static_cast<Codec::TYPE>(ch.codec);
+    auto c = create_conn(ch.fd, codec);
+    if (c == nullptr) {
+        close_fd(ch.fd);
+        LOG_ERROR("add data fd read event failed, fd: %d", ch.fd);
+        return;
+    }
 
-        LOG_INFO("read from channel, get data: fd: %d, family: %d, codec: %d, system: %d",
-                 ch.fd, ch.family, ch.codec, ch.is_system);
+    if (ch.is_system) {
+        c->set_system(true);
+    } else {
+        c->set_client(true);
+        c->set_pass_through(m_is_gate_pass_through);
+    }
 
-        auto co = m_coroutines->start_co(
-            [this, c](void* arg) {
-                on_handle_requests(c);
-                m_coroutines->add_free_co((stCoRoutine_t*)arg);
-            });
-        if (co == nullptr) {
-            LOG_ERROR("create new corotines failed!");
-            close_conn(c);
-            continue;
-        }
+    LOG_INFO("read from channel, get data: fd: %d, family: %d, codec: %d, system: %d",
+             ch.fd, ch.family, ch.codec, ch.is_system);
+
+    auto co = m_coroutines->start_co(
+        [this, c](void* arg) {
+            on_handle_requests(c);
+            m_coroutines->add_free_co((stCoRoutine_t*)arg);
+        });
+    if (co == nullptr) {
+        LOG_ERROR("create new corotines failed!");
+        close_conn(c);
     }
 }
 
 void Network::on_handle_requests(std::shared_ptr<Connection> c) {
     co_enable_hook_sys();
 
+    if (m_is_edge_trigger) {
+        /* register once, avoid epoll_ctl add/del on every wait. */
+        c->attach_fd_event();
+    }
+
+    if (m_is_io_uring) {
+        /* falls back to poll + read if it fails. */
+        c->attach_uring_recv();
+    }
+
     for (;;) {
         if (!is_valid_conn(c)) {
             LOG_ERROR("invalid conn, id: %llu, fd: %d", c->id(), c->fd());
@@ -627,7 +717,7 @@ void Network::on_handle_requests(std::shared_ptr<Connection> c) {
         if (process_msg(c) != ERR_OK) {
             break;
         } else {
-            co_sleep(1000, c->fd(), POLLIN);
+            c->wait_event(POLLIN, 1000);
         }
     }
 
@@ -645,7 +735,8 @@ int Network::process_tcp_msg(std::shared_ptr<Connection> c) {
     auto old_cnt = c->read_cnt();
     auto old_bytes = c->read_bytes();
 
-    auto msg = std::make_shared<Msg>(c->ft());
+    auto msg = new_msg(c->ft());
+    msg->set_raw(c->is_pass_through());
     auto status = c->conn_read(msg);
     if (status != Codec::STATUS::ERR) {
         m_payload.set_read_cnt(m_payload.read_cnt() + (c->read_cnt() - old_cnt));
@@ -687,8 +778,8 @@ int Network::process_tcp_msg(std::shared_ptr<Connection> c) {
             }
         }
 
-        msg->head()->Clear();
-        msg->body()->Clear();
+        msg->reset(c->ft());
+        msg->set_raw(c->is_pass_through());
 
         status = c->fetch_data(msg);
         LOG_TRACE("conn read result, fd: %d, ret: %d", fd, (int)status);
@@ -742,15 +833,21 @@ std::shared_ptr<Connection> Network::create_conn(int fd, Codec::TYPE codec, bool
 }
 
 std::shared_ptr<Connection> Network::create_conn(int fd) {
-    auto id = new_seq();
+    auto id = m_conns.new_id(fd);
     auto c = std::make_shared<Connection>(logger(), shared_from_this(), fd, id);
     if (c == nullptr) {
         LOG_ERROR("new connection failed! fd: %d", fd);
         return nullptr;
     }
 
-    m_conns[id] = c;
-    m_fd_conns[fd] = id;
+    auto old = m_conns.add(c);
+    if (old != nullptr) {
+        /* the fd has been closed and reused, the old conn is invalid. */
+        LOG_WARN("conflict conn fd, old id: %llu, new id: %llu, fd: %d",
+                 old->id(), id, fd);
+        old->set_state(Connection::STATE::CLOSED);
+        old->detach_fd_event();
+    }
     c->set_keep_alive(m_keep_alive);
     LOG_DEBUG("create connection fd: %d, id: %llu", fd, id);
     return c;
@@ -828,6 +925,20 @@ bool Network::load_config(std::shared_ptr<SysConfig> config) {
         set_keep_alive(secs);
     }
 
+    set_edge_trigger(config->is_edge_trigger());
+    set_gate_pass_through(config->is_gate_pass_through());
+    /* the flush coroutine waits for POLLOUT on the conn's fd event,
+     * without it, the wait conflicts with the reader's poll. */
+    if (config->is_write_cork() && !config->is_edge_trigger()) {
+        LOG_WARN("write cork needs edge trigger, it is off!");
+    }
+    set_write_cork(config->is_write_cork() && config->is_edge_trigger());
+
+    if (!load_io_engine(config->io_engine())) {
+        LOG_ERROR("invalid io engine: %s", config->io_engine().c_str());
+        return false;
+    }
+
     if (config->node_type().empty()) {
         LOG_ERROR("invalid inner node info!");
         return false;
@@ -836,12 +947,32 @@ bool Network::load_config(std::shared_ptr<SysConfig> config) {
     return true;
 }
 
+bool Network::load_io_engine(const std::string& engine) {
+    if (engine.empty() || engine == "epoll") {
+        co_set_io_engine(CO_IO_ENGINE_EPOLL);
+    } else if (engine == "io_uring") {
+        /* must be set before libco's event loop is created. */
+        co_set_io_engine(CO_IO_ENGINE_URING);
+    } else {
+        return false;
+    }
+
+    /* falls back to epoll if the kernel does not support it. */
+    m_is_io_uring = (co_get_io_engine() == CO_IO_ENGINE_URING);
+    LOG_INFO("io engine: %s, config: %s",
+             m_is_io_uring ? "io_uring" : "epoll", engine.c_str());
+    return true;
+}
+
 bool Network::load_worker_data_mgr() {
     m_worker_data_mgr = std::make_shared<WorkerDataMgr>(logger());
     if (m_worker_data_mgr == nullptr) {
         LOG_ERROR("load worker data mgr failed!");
         return false;
     }
+    if (!m_worker_data_mgr->set_balance(m_config->worker_balance())) {
+        return false;
+    }
     return true;
 }
 
@@ -867,6 +998,7 @@ bool Network::load_nodes_conn() {
         LOG_ERROR("alloc nodes conn failed!");
         return true;
     }
+    m_nodes_conn->set_pipeline(m_config->is_node_pipeline());
     return true;
 }
 
@@ -922,6 +1054,16 @@ int Network::send_to(std::shared_ptr<Connection> c, std::shared_ptr<Msg> msg) {
         return ERR_ENCODE_DATA_FAILED;
     }
 
+    if (m_is_write_cork && c->is_client() && c->is_edge_trigger()) {
+        /* flush in flush_dirty_conns(), only client conns, system,
+         * node and ctrl traffic is sent at once. */
+        if (!c->is_dirty()) {
+            c->set_dirty(true);
+            m_dirty_conns.push_back(c);
+        }
+        return ERR_OK;
+    }
+
     for (;;) {
         if (!is_valid_conn(c)) {
             LOG_ERROR("invalid conn, fd: %d, id: %llu", c->fd(), c->id());
@@ -932,7 +1074,7 @@ int Network::send_to(std::shared_ptr<Connection> c, std::shared_ptr<Msg> msg) {
         if (status == Codec::STATUS::OK) {
             return ERR_OK;
         } else if (status == Codec::STATUS::PAUSE) {
-            co_sleep(100, c->fd(), POLLOUT);
+            c->wait_event(POLLOUT, 100);
             continue;
         } else {
             LOG_DEBUG("send data failed! fd: %d", c->fd());
@@ -945,6 +1087,68 @@ int Network::send_to(const fd_t& ft, std::shared_ptr<Msg> msg) {
     return send_to(get_conn(ft), msg);
 }
 
+void Network::flush_dirty_conns() {
+    if (m_dirty_conns.empty()) {
+        return;
+    }
+
+    std::vector<std::shared_ptr<Connection>> conns;
+    conns.swap(m_dirty_conns);
+
+    for (auto& c : conns) {
+        if (!is_valid_conn(c)) {
+            c->set_dirty(false);
+            continue;
+        }
+
+        auto status = conn_write_data(c);
+        if (status == Codec::STATUS::OK) {
+            c->set_dirty(false);
+        } else if (status == Codec::STATUS::PAUSE) {
+            /* socket buffer is full, keep dirty and wait for POLLOUT in a coroutine. */
+            auto co = m_coroutines->start_co(
+                [this, c](void* arg) {
+                    on_handle_flush(c);
+                    m_coroutines->add_free_co((stCoRoutine_t*)arg);
+                });
+            if (co == nullptr) {
+                LOG_ERROR("create flush corotine failed! fd: %d", c->fd());
+                c->set_dirty(false);
+                close_conn(c);
+            }
+        } else {
+            LOG_DEBUG("send data failed! fd: %d", c->fd());
+            c->set_dirty(false);
+            close_conn(c);
+        }
+    }
+}
+
+void Network::on_handle_flush(std::shared_ptr<Connection> c) {
+    co_enable_hook_sys();
+
+    for (;;) {
+        if (!is_valid_conn(c)) {
+            break;
+        }
+
+        c->wait_event(POLLOUT, 100);
+
+        auto status = conn_write_data(c);
+        if (status == Codec::STATUS::PAUSE) {
+            continue;
+        }
+        if (status != Codec::STATUS::OK) {
+            LOG_DEBUG("send data failed! fd: %d", c->fd());
+            c->set_dirty(false);
+            close_conn(c);
+        }
+        break;
+    }
+
+    c->set_dirty(false);
+}
+
 Codec::STATUS Network::conn_write_data(std::shared_ptr<Connection> c) {
     auto old_cnt = c->write_cnt();
     auto old_bytes = c->write_bytes();
@@ -957,12 +1161,11 @@ Codec::STATUS Network::conn_write_data(std::shared_ptr<Connection> c) {
 }
 
 std::shared_ptr<Connection> Network::get_conn(const fd_t& ft) {
-    auto it = m_conns.find(ft.id);
-    if (it == m_conns.end()) {
+    auto c = m_conns.get(ft.id);
+    if (c == nullptr) {
         return nullptr;
     }
 
-    auto c = it->second;
     if (c->fd() != ft.fd) {
         LOG_WARN("conflict conn data, old id: %llu, fd: %d, new id: %llu, fd: %d",
                  c->id(), c->fd(), ft.id, ft.id);
@@ -974,7 +1177,7 @@ std::shared_ptr<Connection> Network::get_conn(const fd_t& ft) {
 
 int Network::send_ack(std::shared_ptr<Msg> req,
                       int err, const std::string& errstr, const std::string& data) {
-    auto msg = std::make_shared<Msg>();
+    auto msg = new_msg();
 
     msg->body()->set_data(data);
     msg->body()->mutable_rsp_result()->set_code(err);
@@ -982,7 +1185,6 @@ int Network::send_ack(std::shared_ptr<Msg> req,
 
     msg->head()->set_seq(req->head()->seq());
     msg->head()->set_cmd(req->head()->cmd() + 1);
-    msg->head()->set_len(msg->body()->ByteSizeLong());
 
     return send_to(req->ft(), msg);
 }
@@ -993,20 +1195,18 @@ int Network::send_req(std::shared_ptr<Connection> c, uint32_t cmd, uint32_t seq,
         return false;
     }
 
-    auto msg = std::make_shared<Msg>();
+    auto msg = new_msg();
     msg->body()->set_data(data);
     msg->head()->set_cmd(cmd);
     msg->head()->set_seq(seq);
-    msg->head()->set_len(msg->body()->ByteSizeLong());
     return send_to(c, msg);
 }
 
 int Network::send_req(const fd_t& ft, uint32_t cmd, uint32_t seq, const std::string& data) {
-    auto msg = std::make_shared<Msg>();
+    auto msg = new_msg();
     msg->body()->set_data(data);
     msg->head()->set_seq(seq);
     msg->head()->set_cmd(cmd);
-    msg->head()->set_len(msg->body()->ByteSizeLong());
     return send_to(ft, msg);
 }
 
@@ -1016,13 +1216,13 @@ int Network::send_to_manager(int cmd, uint64_t seq, const std::string& data) {
         return ERR_INVALID_PROCESS_TYPE;
     }
 
-    auto it = m_conns.find(m_manager_fctrl.id);
-    if (it == m_conns.end()) {
+    auto c = m_conns.get(m_manager_fctrl.id);
+    if (c == nullptr) {
         LOG_ERROR("can not find manager ctrl fd, fd: %d", m_manager_fctrl.fd);
         return ERR_INVALID_CONN;
     }
 
-    int ret = send_req(it->second, cmd, seq, data);
+    int ret = send_req(c, cmd, seq, data);
     if (ret != ERR_OK) {
         LOG_ALERT("send to parent failed:1! fd: %d", m_manager_fctrl.fd);
         return ret;
@@ -1042,13 +1242,13 @@ int Network::send_to_workers(int cmd, uint64_t seq, const std::string& data) {
     /* manger and workers communicate through socketpair. */
     const auto& workers = m_worker_data_mgr->get_infos();
     for (const auto& v : workers) {
-        auto it = m_conns.find(v.second->fctrl.id);
-        if (it == m_conns.end() || it->second->is_invalid()) {
+        auto c = m_conns.get(v.second->fctrl.id);
+        if (c == nullptr || c->is_invalid()) {
             LOG_ALERT("ctrl fd is invalid! fd: %d", v.second->fctrl.fd);
             continue;
         }
 
-        if (send_req(it->second, cmd, seq, data) != ERR_OK) {
+        if (send_req(c, cmd, seq, data) != ERR_OK) {
             LOG_ALERT("send to worker failed! fd: %d", v.second->fctrl.fd);
             continue;
         }
@@ -1069,12 +1269,11 @@ void Network::destroy() {
 }
 
 void Network::close_fds() {
-    for (const auto& it : m_conns) {
-        std::shared_ptr<Connection> c = it.second;
-        if (c && !c->is_invalid()) {
+    m_conns.for_each([this](std::shared_ptr<Connection>& c) {
+        if (!c->is_invalid()) {
             close_fd(c->fd());
         }
-    }
+    });
     m_conns.clear();
     m_node_conns.clear();
 }
@@ -1093,12 +1292,16 @@ bool Network::close_conn(std::shared_ptr<Connection> c) {
 }
 
 bool Network::close_conn(uint64_t id) {
-    auto it = m_conns.find(id);
-    if (it == m_conns.end()) {
+    auto c = m_conns.get(id);
+    if (c == nullptr) {
         return false;
     }
 
-    auto c = it->second;
+    if (c->is_dirty() && c->has_send_data() && !c->is_invalid()) {
+        /* corked data, try to send it before closing. */
+        conn_write_data(c);
+    }
+
     c->set_state(Connection::STATE::CLOSED);
 
     if (!c->get_node_id().empty()) {
@@ -1107,16 +1310,9 @@ bool Network::close_conn(uint64_t id) {
 
     LOG_DEBUG("close conn, fd: %d, id: %llu", c->fd(), c->id());
 
-    m_conns.erase(it);
-    auto itr = m_fd_conns.find(c->fd());
-    if (itr != m_fd_conns.end() && itr->second == c->ft().id) {
-        LOG_DEBUG("remove fdt done! fd: %d, id: %llu", c->fd(), c->id());
-        m_fd_conns.erase(c->fd());
-        close_fd(c->fd());
-    } else {
-        LOG_WARN("remove fdt failed, fd: %d, id: %llu", c->fd(), c->id());
-    }
-
+    m_conns.del(id);
+    c->detach_fd_event();
+    close_fd(c->fd());
     return true;
 }
 
@@ -1128,29 +1324,13 @@ bool Network::is_valid_conn(std::shared_ptr<Connection> c) {
 }
 
 bool Network::is_valid_conn(uint64_t id) {
-    auto it = m_conns.find(id);
-    if (it == m_conns.end()) {
-        LOG_WARN("can not find client id: %d", id);
-        return false;
-    }
-
-    std::shared_ptr<Connection> c = it->second;
-    if (c->is_invalid()) {
-        return false;
-    }
-
-    auto itr = m_fd_conns.find(c->fd());
-    if (itr == m_fd_conns.end()) {
-        LOG_WARN("can not find conn fd, fd: %d", c->fd());
-        return false;
-    }
-
-    if (itr->second != c->id()) {
-        LOG_WARN("invalid conn id, new: %llu, old: %llu", itr->second, c->id());
+    /* the generation in id checks that the fd has not been reused. */
+    auto c = m_conns.get(id);
+    if (c == nullptr) {
+        LOG_WARN("can not find client id: %llu", id);
         return false;
     }
-
-    return true;
+    return !c->is_invalid();
 }
 
 void Network::close_fd(int fd) {
@@ -1171,11 +1351,11 @@ bool Network::set_gate_codec(const std::string& codec_type) {
 }
 
 bool Network::update_conn_state(const fd_t& ft, int state) {
-    auto it = m_conns.find(ft.id);
-    if (it == m_conns.end()) {
+    auto c = m_conns.get(ft.id);
+    if (c == nullptr) {
         return false;
     }
-    it->second->set_state((Connection::STATE)state);
+    c->set_state((Connection::STATE)state);
     return true;
 }
 
@@ -1201,15 +1381,9 @@ int Network::relay_to_node(const std::string& node_type, const std::string& obj,
 }
 
 uint64_t Network::now(bool force) {
-    if (force) {
-        m_now_time = mstime();
-    } else {
-        if ((++m_time_index % 10) == 0) {
-            /* mstime waste too much cpu, so set it at intervals and in timer. */
-            m_now_time = mstime();
-        }
-    }
-    return m_now_time;
+    /* the loop clock is ticked once per event loop's iteration,
+     * all the connections handled in the iteration share it. */
+    return force ? co_tick_ms_precise() : co_tick_ms();
 }
 
 }  // namespace kim
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "codec/codec.h"
+#include "conn_slab.h"
 #include "connection.h"
 #include "coroutines.h"
 #include "module_mgr.h"
@@ -34,8 +35,8 @@ class Network : public INet, public TimerCron, public Logger {
 
     /* for manager. */
     bool create_m(std::shared_ptr<SysConfig> config);
-    /* for worker.  */
-    bool create_w(std::shared_ptr<SysConfig> config, int ctrl_fd, int data_fd, int index);
+    /* for worker, gate_fd: reuseport listen fd which is created by manager. */
+    bool create_w(std::shared_ptr<SysConfig> config, int ctrl_fd, int data_fd, int index, int gate_fd = -1);
 
     bool init_manager_channel(fd_t& fctrl, fd_t& fdata);
 
@@ -47,10 +48,14 @@ class Network : public INet, public TimerCron, public Logger {
     bool set_gate_codec(const std::string& codec);
     void set_keep_alive(uint64_t ms) { m_keep_alive = ms; }
     uint64_t keep_alive() { return m_keep_alive; }
+    void set_edge_trigger(bool on) { m_is_edge_trigger = on; }
+    void set_gate_pass_through(bool on) { m_is_gate_pass_through = on; }
+    void set_write_cork(bool on) { m_is_write_cork = on; }
     bool is_request(int cmd) { return (cmd & 0x00000001); }
 
     virtual uint64_t now(bool force = false) override;
     virtual uint64_t new_seq() override { return ++m_seq; }
+    virtual std::shared_ptr<Msg> new_msg(const fd_t& ft = fd_t()) override { return m_msg_pool->alloc(ft); }
     virtual CJsonObject* config() override { return m_config->config(); }
 
     /* pro's type. */
@@ -114,6 +119,7 @@ class Network : public INet, public TimerCron, public Logger {
 
    private:
     bool load_config(std::shared_ptr<SysConfig> config);
+    bool load_io_engine(const std::string& engine);
     bool load_public(std::shared_ptr<SysConfig> config);
     bool load_worker_data_mgr();
     bool load_modules();
@@ -136,24 +142,31 @@ class Network : public INet, public TimerCron, public Logger {
     void on_handle_accept_nodes_conn();
     void on_handle_accept_gate_conn();
     void on_handle_read_transfer_fd(int fd);
+    void add_transfer_conn(const channel_t& ch);
+    void transfer_fds(int channel_fd, std::vector<channel_t>& chs); /* batch of fds to worker. */
     void on_handle_requests(std::shared_ptr<Connection> c);
+    void on_handle_flush(std::shared_ptr<Connection> c);
+
+    /* cork. */
+    void flush_dirty_conns();
 
    private:
     std::shared_ptr<SysConfig> m_config = nullptr;   /* system config data. */
     Codec::TYPE m_gate_codec = Codec::TYPE::UNKNOWN; /* gate codec type. */
 
-    std::unordered_map<int, uint64_t> m_fd_conns;                              /* key fd, value: conn id. */
-    std::unordered_map<uint64_t, std::shared_ptr<Connection>> m_conns;         /* key: fd, value: connection. */
+    ConnSlab m_conns;                                                          /* index: fd, conn id with generation. */
     std::unordered_map<std::string, std::shared_ptr<Connection>> m_node_conns; /* key: node_id, value: connection. */
 
     uint64_t m_seq = 0;          /* incremental serial number. */
     char m_errstr[ANET_ERR_LEN]; /* error string. */
 
-    int m_time_index = 0;
-    uint64_t m_now_time = 0;
-
     TYPE m_type = TYPE::UNKNOWN;                                /* owner type. */
     uint64_t m_keep_alive = IO_TIMEOUT_VAL;                     /* io timeout. */
+    bool m_is_edge_trigger = false;                             /* conn's fd stays in epoll (EPOLLET). */
+    bool m_is_gate_pass_through = false;                        /* gate relays client's msgs without decoding body. */
+    bool m_is_write_cork = false;                               /* flush sending data once per event loop's tick. */
+    bool m_is_io_uring = false;                                 /* libco's io engine is io_uring. */
+    std::vector<std::shared_ptr<Connection>> m_dirty_conns;     /* cork, conns wait for flush. */
     std::shared_ptr<WorkerDataMgr> m_worker_data_mgr = nullptr; /* manager handle worker data. */
 
     /* node for inner servers. */
@@ -168,7 +181,10 @@ class Network : public INet, public TimerCron, public Logger {
     fd_t m_manager_fctrl; /* channel for send message. */
     fd_t m_manager_fdata; /* channel for transfer fd. */
 
-    Payload m_payload; /* pro's payload data. */
+    Payload m_payload;          /* pro's payload data. */
+    uint64_t m_recv_fd_cnt = 0; /* client fds received from manager, used by worker. */
+
+    std::shared_ptr<MsgPool> m_msg_pool = std::make_shared<MsgPool>(); /* recycle request/reply msgs. */
 
     std::shared_ptr<Nodes> m_nodes = nullptr;            /* server nodes. ketama nodes manager. */
     std::unique_ptr<NodeConn> m_nodes_conn = nullptr;    /* node connection pool. */
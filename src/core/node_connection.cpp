@@ -12,6 +12,7 @@
 #define MAX_CONN_CNT 10
 #define HEART_BEAT_TIME 2000
 #define MAX_RECV_DATA_TIME 3000
+#define MAX_PIPELINE_CNT 1024 /* max requests in flight per conn. */
 
 namespace kim {
 
@@ -26,11 +27,10 @@ void NodeConn::destroy() {
     for (auto& it : m_coroutines) {
         auto ad = it.second;
         for (auto cd : ad->coroutines) {
-            clear_co_tasks(cd);
             if (cd->c != nullptr) {
-                net()->close_conn(cd->c);
-                cd->c = nullptr;
+                close_co_conn(cd, cd->c, ERR_NODE_CONNECT_FAILED);
             }
+            clear_co_tasks(cd);
             if (cd->cond != nullptr) {
                 co_cond_free(cd->cond);
                 cd->cond = nullptr;
@@ -39,6 +39,14 @@ void NodeConn::destroy() {
                 co_free(cd->co);
                 cd->co = nullptr;
             }
+            if (cd->reader_cond != nullptr) {
+                co_cond_free(cd->reader_cond);
+                cd->reader_cond = nullptr;
+            }
+            if (cd->reader_co != nullptr) {
+                co_free(cd->reader_co);
+                cd->reader_co = nullptr;
+            }
         }
     }
 }
@@ -108,7 +116,14 @@ NodeConn::get_co_data(const std::string& node_type, const std::string& obj) {
 
     ad->coroutines.push_back(cd);
 
-    co_create(&(cd->co), nullptr, [this, cd](void* arg) { on_handle_task(cd); });
+    if (m_is_pipeline) {
+        cd->reader_cond = co_cond_alloc();
+        co_create(&(cd->reader_co), nullptr, [this, cd](void* arg) { on_handle_pipeline_reply(cd); });
+        co_create(&(cd->co), nullptr, [this, cd](void* arg) { on_handle_pipeline_task(cd); });
+        co_resume(cd->reader_co);
+    } else {
+        co_create(&(cd->co), nullptr, [this, cd](void* arg) { on_handle_task(cd); });
+    }
     co_resume(cd->co);
     return cd;
 }
@@ -138,7 +153,7 @@ void NodeConn::on_handle_task(std::shared_ptr<co_data_t> cd) {
             if (net()->now() - cd->c->active_time() > HEART_BEAT_TIME) {
                 ret = net()->sys_cmd()->send_heart_beat(cd->c);
                 if (ret == ERR_OK) {
-                    auto msg = std::make_shared<Msg>();
+                    auto msg = net()->new_msg();
                     ret = recv_data(cd->c, msg);
                     if (ret == ERR_OK) {
                         continue;
@@ -168,6 +183,200 @@ void NodeConn::on_handle_task(std::shared_ptr<co_data_t> cd) {
     }
 }
 
+/* pipeline writer: send requests back-to-back, don't wait for their replies. */
+void NodeConn::on_handle_pipeline_task(std::shared_ptr<co_data_t> cd) {
+    int ret;
+    uint32_t seq;
+
+    for (;;) {
+        if (cd->tasks.empty() || cd->waiting.size() >= MAX_PIPELINE_CNT) {
+            co_cond_timedwait(cd->cond, 1000);
+        }
+
+        if (cd->c == nullptr) {
+            cd->c = node_connect(cd->node_type, cd->host, cd->port, cd->worker_index);
+            if (cd->c == nullptr) {
+                clear_co_tasks(cd);
+                continue;
+            }
+            /* reader and writer wait on the same fd. */
+            cd->c->attach_fd_event();
+        }
+
+        auto c = cd->c;
+
+        if (cd->waiting.size() >= MAX_PIPELINE_CNT) {
+            continue;
+        }
+
+        std::shared_ptr<task_t> task = nullptr;
+        if (cd->tasks.empty()) {
+            if (!cd->waiting.empty() || net()->now() - c->active_time() <= HEART_BEAT_TIME) {
+                continue;
+            }
+            /* heart beat has no coroutine waiting for it, but it times out like others. */
+            task = std::make_shared<task_t>();
+        } else {
+            task = cd->tasks.front();
+            cd->tasks.pop();
+        }
+
+        /* register before sending, the reply may be handled once the writer yields. */
+        if (++cd->seq == 0) {
+            ++cd->seq;
+        }
+        seq = cd->seq;
+        cd->waiting[seq] = task;
+        cd->timeouts.push({net()->now() + MAX_RECV_DATA_TIME, seq});
+        co_cond_signal(cd->reader_cond);
+
+        if (task->co == nullptr) {
+            ret = net()->sys_cmd()->send_heart_beat(c, seq);
+        } else {
+            task->seq = task->req->head()->seq();
+            task->req->head()->set_seq(seq);
+            ret = net()->send_to(c, task->req);
+        }
+
+        /* the task may be woken up (conn closed) while sending, then it's not ours. */
+        auto it = cd->waiting.find(seq);
+        if (it == cd->waiting.end() || it->second != task) {
+            continue;
+        }
+
+        if (task->co != nullptr) {
+            task->req->head()->set_seq(task->seq);
+        }
+
+        if (ret != ERR_OK) {
+            LOG_ERROR("send to node failed! ret: %d, fd: %d", ret, c->fd());
+            cd->waiting.erase(it);
+            wake_task(task, ret);
+            close_co_conn(cd, c, ret);
+        }
+    }
+}
+
+/* pipeline reader: match replies to requests by seq. */
+void NodeConn::on_handle_pipeline_reply(std::shared_ptr<co_data_t> cd) {
+    auto msg = net()->new_msg();
+
+    for (;;) {
+        auto c = cd->c;
+        if (c == nullptr || cd->waiting.empty()) {
+            std::queue<std::pair<uint64_t, uint32_t>>().swap(cd->timeouts);
+            co_cond_timedwait(cd->reader_cond, 1000);
+            continue;
+        }
+
+        /* keep the body undecoded, it's decoded by the task's ack. */
+        msg->reset(c->ft());
+        msg->set_raw(true);
+
+        auto status = c->conn_read(msg);
+        if (status == Codec::STATUS::OK) {
+            handle_reply(cd, msg);
+            continue;
+        }
+
+        if (status == Codec::STATUS::PAUSE) {
+            check_timeouts(cd);
+            if (cd->c == c && !cd->waiting.empty()) {
+                c->wait_event(POLLIN, 100);
+            }
+            continue;
+        }
+
+        LOG_ERROR("read from node failed! status: %d, fd: %d", (int)status, c->fd());
+        close_co_conn(cd, c, (status == Codec::STATUS::CLOSED) ? ERR_CONN_CLOSED : ERR_READ_DATA_FAILED);
+    }
+}
+
+void NodeConn::handle_reply(std::shared_ptr<co_data_t> cd, std::shared_ptr<Msg> msg) {
+    auto it = cd->waiting.find(msg->head()->seq());
+    if (it == cd->waiting.end()) {
+        LOG_DEBUG("drop reply, maybe timeout! cmd: %d, seq: %u",
+                  msg->head()->cmd(), msg->head()->seq());
+        return;
+    }
+
+    auto task = it->second;
+    cd->waiting.erase(it);
+    if (cd->waiting.size() == MAX_PIPELINE_CNT - 1) {
+        co_cond_signal(cd->cond);
+    }
+
+    if (task->co == nullptr) {
+        return; /* heart beat. */
+    }
+
+    auto ack = task->ack;
+    ack->head()->CopyFrom(*msg->head());
+    ack->head()->set_seq(task->seq);
+    ack->set_route_key(msg->route_key());
+    if (ack->is_raw()) {
+        ack->set_raw_body(msg->raw_body().data(), msg->raw_body().size());
+    } else if (!ack->body()->ParseFromString(msg->raw_body())) {
+        LOG_ERROR("parse ack body failed! cmd: %d, seq: %u", ack->head()->cmd(), task->seq);
+        wake_task(task, ERR_INVALID_PROTOBUF_PACKET);
+        return;
+    }
+    wake_task(task, ERR_OK);
+}
+
+void NodeConn::check_timeouts(std::shared_ptr<co_data_t> cd) {
+    auto now = net()->now();
+    while (!cd->timeouts.empty() && cd->timeouts.front().first <= now) {
+        auto seq = cd->timeouts.front().second;
+        cd->timeouts.pop();
+
+        auto it = cd->waiting.find(seq);
+        if (it == cd->waiting.end()) {
+            continue;
+        }
+
+        auto task = it->second;
+        if (task->co == nullptr) {
+            /* heart beat timeout, the node is not alive. */
+            LOG_ERROR("heart beat timeout! node: %s, host: %s, port: %d",
+                      cd->node_type.c_str(), cd->host.c_str(), cd->port);
+            close_co_conn(cd, cd->c, ERR_READ_DATA_TIMEOUT);
+            return;
+        }
+
+        LOG_WARN("wait for reply timeout! node: %s, seq: %u", cd->node_type.c_str(), seq);
+        cd->waiting.erase(it);
+        wake_task(task, ERR_READ_DATA_TIMEOUT);
+    }
+}
+
+void NodeConn::wake_task(std::shared_ptr<task_t> task, int ret) {
+    if (task->co == nullptr) {
+        return;
+    }
+    /* the caller's coroutine is parked, so its req is still ours, restore its seq. */
+    task->req->head()->set_seq(task->seq);
+    task->ret = ret;
+    co_resume(task->co);
+}
+
+void NodeConn::close_co_conn(std::shared_ptr<co_data_t> cd, std::shared_ptr<Connection> c, int ret) {
+    if (c == nullptr || cd->c != c) {
+        return; /* closed by the other coroutine. */
+    }
+
+    net()->close_conn(c);
+    cd->c = nullptr;
+
+    std::queue<std::pair<uint64_t, uint32_t>>().swap(cd->timeouts);
+    auto waiting = std::move(cd->waiting);
+    cd->waiting.clear();
+    for (auto& it : waiting) {
+        wake_task(it.second, ret);
+    }
+    clear_co_tasks(cd);
+}
+
 int NodeConn::recv_data(std::shared_ptr<Connection> c, std::shared_ptr<Msg> msg) {
     for (;;) {
         auto status = c->conn_read(msg);
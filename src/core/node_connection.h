@@ -18,6 +18,7 @@ class NodeConn : public Logger, public Net {
         std::shared_ptr<Msg> req = nullptr;
         int ret = ERR_FAILED; /* result. */
         std::shared_ptr<Msg> ack = nullptr;
+        uint32_t seq = 0; /* req's own seq, pipeline replaces it when sending. */
     } task_t;
 
     /* coroutine's arg data.  */
@@ -30,6 +31,13 @@ class NodeConn : public Logger, public Net {
         stCoCond_t* cond = nullptr;                /* coroutine cond. */
         stCoRoutine_t* co = nullptr;               /* redis conn's coroutine. */
         std::queue<std::shared_ptr<task_t>> tasks; /* tasks wait to be handled. */
+
+        /* pipeline: requests are sent back-to-back, replies are matched by seq. */
+        stCoCond_t* reader_cond = nullptr;                             /* wake reader when requests are sent. */
+        stCoRoutine_t* reader_co = nullptr;                            /* read replies from conn. */
+        uint32_t seq = 0;                                              /* seq for requests in flight. */
+        std::unordered_map<uint32_t, std::shared_ptr<task_t>> waiting; /* key: seq, tasks wait for reply. */
+        std::queue<std::pair<uint64_t, uint32_t>> timeouts;            /* (expire time, seq), in sending order. */
     } co_data_t;
 
     /* connections to node. */
@@ -53,15 +61,30 @@ class NodeConn : public Logger, public Net {
      * @param head_out: ack msg head, recv from obj node.
      * @param body_out: ack msg body, recv from obj node.
      *
+     * if req/ack are raw msgs (Msg::is_raw), their bodies are relayed
+     * as undecoded bytes, only the heads are decoded/encoded.
+     *
      * @return error.h / enum E_ERROR.
      */
     int relay_to_node(const std::string& node_type, const std::string& obj, std::shared_ptr<Msg> req, std::shared_ptr<Msg> ack);
 
+    /* multiple requests in flight per node connection. */
+    void set_pipeline(bool on) { m_is_pipeline = on; }
+    bool is_pipeline() { return m_is_pipeline; }
+
    protected:
     std::shared_ptr<co_data_t> get_co_data(const std::string& node_type, const std::string& obj);
     void on_handle_task(std::shared_ptr<co_data_t> cd);
     void clear_co_tasks(std::shared_ptr<co_data_t> cd);
 
+    /* pipeline. */
+    void on_handle_pipeline_task(std::shared_ptr<co_data_t> cd);
+    void on_handle_pipeline_reply(std::shared_ptr<co_data_t> cd);
+    void handle_reply(std::shared_ptr<co_data_t> cd, std::shared_ptr<Msg> msg);
+    void check_timeouts(std::shared_ptr<co_data_t> cd);
+    void wake_task(std::shared_ptr<task_t> task, int ret);
+    void close_co_conn(std::shared_ptr<co_data_t> cd, std::shared_ptr<Connection> c, int ret);
+
     /* for nodes connect. */
     int handle_sys_message(std::shared_ptr<Connection> c);
     int recv_data(std::shared_ptr<Connection> c, std::shared_ptr<Msg> msg);
@@ -70,6 +93,7 @@ class NodeConn : public Logger, public Net {
 
    private:
     char m_errstr[ANET_ERR_LEN]; /* error string. */
+    bool m_is_pipeline = false;  /* multiple requests in flight per conn. */
     std::unordered_map<std::string, std::shared_ptr<co_array_data_t>> m_coroutines;
 };
 
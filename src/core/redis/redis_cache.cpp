@@ -0,0 +1,278 @@
+#include "redis_cache.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+namespace kim {
+
+/* read cmds whose reply depends only on the first argument (key). */
+static const char* g_cacheable_cmds[] = {
+    "get", "strlen", "getrange",
+    "hget", "hmget", "hgetall", "hexists", "hlen", "hkeys", "hvals",
+    "smembers", "sismember", "scard",
+    "zrange", "zrevrange", "zrangebyscore", "zscore", "zcard",
+    "lrange", "llen", "lindex",
+    nullptr};
+
+/* size of an entry's bookkeeping, besides its strings and reply. */
+static const size_t ENTRY_OVERHEAD = 128;
+
+/* RESP bulk string: "$len\r\ndata\r\n", returns the next position, nullptr: invalid. */
+static const char* parse_bulk(const char* p, const char* end, const char** data, size_t* len) {
+    if (p >= end || *p != '$') {
+        return nullptr;
+    }
+    char* q = nullptr;
+    long n = strtol(p + 1, &q, 10);
+    if (n < 0 || q + 2 > end || q[0] != '\r' || q[1] != '\n' || q + 2 + n + 2 > end) {
+        return nullptr;
+    }
+    *data = q + 2;
+    *len = (size_t)n;
+    return q + 2 + n + 2;
+}
+
+RedisCache::RedisCache(size_t max_memory) : m_max_memory(max_memory) {
+}
+
+RedisCache::~RedisCache() {
+    for (auto& e : m_entries) {
+        freeReplyObject(e.reply);
+    }
+}
+
+bool RedisCache::is_cacheable(const char* cmd, size_t len, std::string& key) {
+    const char* end = cmd + len;
+    if (len == 0 || cmd[0] != '*') {
+        return false;
+    }
+
+    char* q = nullptr;
+    long argc = strtol(cmd + 1, &q, 10);
+    if (argc < 2 || q + 2 > end) {
+        return false;
+    }
+
+    const char* name = nullptr;
+    size_t name_len = 0;
+    const char* arg = nullptr;
+    size_t arg_len = 0;
+    const char* p = parse_bulk(q + 2, end, &name, &name_len);
+    if (p == nullptr || parse_bulk(p, end, &arg, &arg_len) == nullptr) {
+        return false;
+    }
+
+    for (int i = 0; g_cacheable_cmds[i] != nullptr; i++) {
+        if (strlen(g_cacheable_cmds[i]) == name_len &&
+            strncasecmp(g_cacheable_cmds[i], name, name_len) == 0) {
+            key.assign(arg, arg_len);
+            return true;
+        }
+    }
+    return false;
+}
+
+redisReply* RedisCache::get(const char* cmd, size_t len) {
+    auto it = m_cmds.find(std::string(cmd, len));
+    if (it == m_cmds.end()) {
+        m_stats.misses++;
+        return nullptr;
+    }
+
+    m_stats.hits++;
+    m_entries.splice(m_entries.begin(), m_entries, it->second);
+    return copy_reply(it->second->reply);
+}
+
+void RedisCache::set(const std::string& key, const char* cmd, size_t len, const redisReply* r) {
+    if (r == nullptr || r->type == REDIS_REPLY_ERROR) {
+        return;
+    }
+
+    std::string c(cmd, len);
+    auto it = m_cmds.find(c);
+    if (it != m_cmds.end()) {
+        remove(it->second);
+    }
+
+    size_t size = ENTRY_OVERHEAD + c.size() * 2 + key.size() * 2 + reply_size(r);
+    if (size > m_max_memory / 2) {
+        return;
+    }
+
+    while (!m_entries.empty() && m_stats.memory + size > m_max_memory) {
+        remove(--m_entries.end());
+        m_stats.evictions++;
+    }
+
+    entry_t e;
+    e.reply = copy_reply(r);
+    if (e.reply == nullptr) {
+        return;
+    }
+    e.cmd = c;
+    e.key = key;
+    e.size = size;
+    m_entries.push_front(e);
+    m_cmds[c] = m_entries.begin();
+    m_keys[key].push_back(c);
+
+    m_stats.fills++;
+    m_stats.entries++;
+    m_stats.memory += size;
+}
+
+void RedisCache::invalidate(const char* key, size_t len) {
+    m_stats.invalidations++;
+    remove_key(std::string(key, len));
+}
+
+void RedisCache::invalidate_cmd(const char* cmd, size_t len) {
+    const char* end = cmd + len;
+    if (len == 0 || cmd[0] != '*' || (m_keys.empty() && m_fills.empty())) {
+        return;
+    }
+
+    char* q = nullptr;
+    long argc = strtol(cmd + 1, &q, 10);
+    if (argc < 2 || q + 2 > end) {
+        return;
+    }
+
+    const char* arg = nullptr;
+    size_t arg_len = 0;
+    const char* p = parse_bulk(q + 2, end, &arg, &arg_len); /* cmd's name. */
+    for (long i = 1; p != nullptr && i < argc; i++) {
+        if ((p = parse_bulk(p, end, &arg, &arg_len)) != nullptr) {
+            remove_key(std::string(arg, arg_len));
+        }
+    }
+}
+
+void RedisCache::remove_key(const std::string& k) {
+    auto itf = m_fills.find(k);
+    if (itf != m_fills.end()) {
+        itf->second.is_dirty = true;
+    }
+
+    auto it = m_keys.find(k);
+    if (it == m_keys.end()) {
+        return;
+    }
+
+    std::vector<std::string> cmds;
+    cmds.swap(it->second);
+    for (const auto& c : cmds) {
+        auto itc = m_cmds.find(c);
+        if (itc != m_cmds.end()) {
+            remove(itc->second);
+        }
+    }
+}
+
+void RedisCache::clear() {
+    for (auto& e : m_entries) {
+        freeReplyObject(e.reply);
+    }
+    m_entries.clear();
+    m_cmds.clear();
+    m_keys.clear();
+    m_stats.entries = 0;
+    m_stats.memory = 0;
+    m_epoch++;
+}
+
+uint64_t RedisCache::begin_fill(const std::string& key) {
+    m_fills[key].cnt++;
+    return m_epoch;
+}
+
+bool RedisCache::end_fill(const std::string& key, uint64_t ticket) {
+    auto it = m_fills.find(key);
+    if (it == m_fills.end()) {
+        return false;
+    }
+
+    bool ok = (!it->second.is_dirty && ticket == m_epoch);
+    if (--it->second.cnt <= 0) {
+        m_fills.erase(it);
+    }
+    return ok;
+}
+
+void RedisCache::remove(std::list<entry_t>::iterator it) {
+    auto itk = m_keys.find(it->key);
+    if (itk != m_keys.end()) {
+        auto& cmds = itk->second;
+        for (size_t i = 0; i < cmds.size(); i++) {
+            if (cmds[i] == it->cmd) {
+                cmds[i] = cmds.back();
+                cmds.pop_back();
+                break;
+            }
+        }
+        if (cmds.empty()) {
+            m_keys.erase(itk);
+        }
+    }
+
+    m_stats.entries--;
+    m_stats.memory -= it->size;
+    freeReplyObject(it->reply);
+    m_cmds.erase(it->cmd);
+    m_entries.erase(it);
+}
+
+redisReply* RedisCache::copy_reply(const redisReply* r) {
+    redisReply* c = (redisReply*)malloc(sizeof(redisReply));
+    if (c == nullptr) {
+        return nullptr;
+    }
+
+    *c = *r;
+    c->str = nullptr;
+    c->element = nullptr;
+
+    if (r->str != nullptr) {
+        c->str = (char*)malloc(r->len + 1);
+        if (c->str == nullptr) {
+            c->elements = 0;
+            freeReplyObject(c);
+            return nullptr;
+        }
+        memcpy(c->str, r->str, r->len);
+        c->str[r->len] = '\0';
+    }
+
+    if (r->element != nullptr) {
+        c->element = (redisReply**)calloc(r->elements, sizeof(redisReply*));
+        if (c->element == nullptr) {
+            c->elements = 0;
+            freeReplyObject(c);
+            return nullptr;
+        }
+        for (size_t i = 0; i < r->elements; i++) {
+            if (r->element[i] != nullptr) {
+                c->element[i] = copy_reply(r->element[i]);
+                if (c->element[i] == nullptr) {
+                    freeReplyObject(c);
+                    return nullptr;
+                }
+            }
+        }
+    }
+    return c;
+}
+
+size_t RedisCache::reply_size(const redisReply* r) {
+    size_t size = sizeof(redisReply) + r->len;
+    for (size_t i = 0; i < r->elements; i++) {
+        if (r->element[i] != nullptr) {
+            size += sizeof(redisReply*) + reply_size(r->element[i]);
+        }
+    }
+    return size;
+}
+
+}  // namespace kim
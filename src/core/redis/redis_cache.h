@@ -0,0 +1,89 @@
+#pragma once
+
+#include <hiredis/hiredis.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace kim {
+
+/**
+ * client side cache of redis read cmds' replies, key: the encoded cmd (RESP).
+ * entries are kept valid by redis server assisted client side caching
+ * (CLIENT TRACKING), the invalidated keys' entries are removed,
+ * the least recently used entries are evicted when memory exceeds the limit.
+ */
+class RedisCache {
+   public:
+    typedef struct stats_s {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t fills = 0;         /* replies cached. */
+        uint64_t evictions = 0;     /* entries evicted by memory limit. */
+        uint64_t invalidations = 0; /* keys invalidated by redis. */
+        size_t entries = 0;
+        size_t memory = 0;
+        double hit_ratio() const { return (hits + misses) ? (double)hits / (hits + misses) : 0.0; }
+    } stats_t;
+
+    RedisCache(size_t max_memory);
+    virtual ~RedisCache();
+
+    /* a read cmd with one key (GET/HGET/HGETALL...), which can be cached. */
+    static bool is_cacheable(const char* cmd, size_t len, std::string& key);
+
+    /* a copy of the cached reply, free it by freeReplyObject, nullptr: miss. */
+    redisReply* get(const char* cmd, size_t len);
+    void set(const std::string& key, const char* cmd, size_t len, const redisReply* r);
+    void invalidate(const char* key, size_t len);
+    /* a write cmd of this client, redis's invalidation of its keys arrives later
+     * on another conn, so every arg which may be a key is invalidated locally. */
+    void invalidate_cmd(const char* cmd, size_t len);
+    void clear();
+
+    /* a key's fill (read from redis) may race with its invalidation, which arrives
+     * on another conn, so the reply is cached only if no invalidation came
+     * during the fill. begin_fill returns a ticket for end_fill. */
+    uint64_t begin_fill(const std::string& key);
+    bool end_fill(const std::string& key, uint64_t ticket);
+
+    const stats_t& stats() const { return m_stats; }
+
+    /* deep copy, allocated as hiredis does, free it by freeReplyObject. */
+    static redisReply* copy_reply(const redisReply* r);
+
+   private:
+    typedef struct entry_s {
+        std::string cmd;
+        std::string key;
+        redisReply* reply = nullptr;
+        size_t size = 0;
+    } entry_t;
+
+    typedef struct fill_s {
+        int cnt = 0;
+        bool is_dirty = false; /* invalidated while filling. */
+    } fill_t;
+
+    void remove(std::list<entry_t>::iterator it);
+    void remove_key(const std::string& key);
+    static size_t reply_size(const redisReply* r);
+
+   private:
+    size_t m_max_memory = 0;
+    uint64_t m_epoch = 0; /* clear() makes all fills' tickets invalid. */
+    stats_t m_stats;
+    std::list<entry_t> m_entries; /* lru list, the front is the most recently used. */
+    /* key: cmd, value: entry. */
+    std::unordered_map<std::string, std::list<entry_t>::iterator> m_cmds;
+    /* key: redis key, value: cmds which read the key. */
+    std::unordered_map<std::string, std::vector<std::string>> m_keys;
+    /* key: redis key, value: fills in flight. */
+    std::unordered_map<std::string, fill_t> m_fills;
+};
+
+}  // namespace kim
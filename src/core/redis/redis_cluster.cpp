@@ -0,0 +1,279 @@
+#include "redis_cluster.h"
+
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+namespace kim {
+
+/* CRC16-CCITT (XMODEM), as redis cluster uses. */
+static uint16_t crc16(const char* buf, size_t len) {
+    uint16_t crc = 0;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= (uint16_t)((uint8_t)buf[i]) << 8;
+        for (int j = 0; j < 8; j++) {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+/* RESP bulk string: "$len\r\ndata\r\n", returns the next position, nullptr: invalid. */
+static const char* parse_bulk(const char* p, const char* end, const char** data, size_t* len) {
+    if (p >= end || *p != '$') {
+        return nullptr;
+    }
+    char* q = nullptr;
+    long n = strtol(p + 1, &q, 10);
+    if (n < 0 || q + 2 > end || q[0] != '\r' || q[1] != '\n' || q + 2 + n + 2 > end) {
+        return nullptr;
+    }
+    *data = q + 2;
+    *len = (size_t)n;
+    return q + 2 + n + 2;
+}
+
+RedisCluster::RedisCluster(const std::string& host, int port) {
+    m_seed.host = host;
+    m_seed.port = port;
+    m_slots.assign(SLOT_CNT, -1);
+}
+
+int RedisCluster::key_slot(const char* key, size_t len) {
+    /* hash tag: the part between the first '{' and the next '}'. */
+    const char* s = (const char*)memchr(key, '{', len);
+    if (s != nullptr) {
+        const char* e = (const char*)memchr(s + 1, '}', len - (s + 1 - key));
+        if (e != nullptr && e > s + 1) {
+            key = s + 1;
+            len = e - key;
+        }
+    }
+    return crc16(key, len) & (SLOT_CNT - 1);
+}
+
+bool RedisCluster::cmd_key(const char* cmd, size_t len, const char** key, size_t* key_len) {
+    const char* end = cmd + len;
+    if (len == 0 || cmd[0] != '*') {
+        return false;
+    }
+
+    char* q = nullptr;
+    long argc = strtol(cmd + 1, &q, 10);
+    if (argc < 2 || q + 2 > end) {
+        return false;
+    }
+
+    const char* p = q + 2;
+    const char* name = nullptr;
+    size_t name_len = 0;
+    if ((p = parse_bulk(p, end, &name, &name_len)) == nullptr) {
+        return false;
+    }
+
+    /* EVAL script numkeys key [key ...] arg [arg ...] */
+    int index = 1;
+    if ((name_len == 4 && strncasecmp(name, "eval", 4) == 0) ||
+        (name_len == 7 && strncasecmp(name, "evalsha", 7) == 0)) {
+        index = 3;
+    }
+
+    const char* arg = nullptr;
+    size_t arg_len = 0;
+    for (int i = 1; i <= index && i < argc; i++) {
+        if ((p = parse_bulk(p, end, &arg, &arg_len)) == nullptr) {
+            return false;
+        }
+        if (i == 2 && index == 3 && atoi(std::string(arg, arg_len).c_str()) <= 0) {
+            return false;
+        }
+        if (i == index) {
+            *key = arg;
+            *key_len = arg_len;
+            return true;
+        }
+    }
+    return false;
+}
+
+int RedisCluster::cmd_block_time(const char* cmd, size_t len) {
+    const char* end = cmd + len;
+    if (len == 0 || cmd[0] != '*') {
+        return 0;
+    }
+
+    char* q = nullptr;
+    long argc = strtol(cmd + 1, &q, 10);
+    if (argc < 2 || q + 2 > end) {
+        return 0;
+    }
+
+    const char* p = q + 2;
+    const char* name = nullptr;
+    size_t name_len = 0;
+    if ((p = parse_bulk(p, end, &name, &name_len)) == nullptr ||
+        name_len == 0 || strchr("bBwWxX", name[0]) == nullptr) {
+        /* most cmds are not blocking, skip them by the name's first letter. */
+        return 0;
+    }
+
+    std::vector<std::string> args;
+    const char* arg = nullptr;
+    size_t arg_len = 0;
+    for (long i = 1; i < argc; i++) {
+        if ((p = parse_bulk(p, end, &arg, &arg_len)) == nullptr) {
+            return 0;
+        }
+        args.emplace_back(arg, arg_len);
+    }
+
+    double secs = 0;
+    std::string s(name, name_len);
+    if (strcasecmp(s.c_str(), "blpop") == 0 || strcasecmp(s.c_str(), "brpop") == 0 ||
+        strcasecmp(s.c_str(), "brpoplpush") == 0 || strcasecmp(s.c_str(), "blmove") == 0 ||
+        strcasecmp(s.c_str(), "bzpopmin") == 0 || strcasecmp(s.c_str(), "bzpopmax") == 0) {
+        /* BLPOP key [key ...] timeout */
+        secs = atof(args.back().c_str());
+    } else if (strcasecmp(s.c_str(), "blmpop") == 0 || strcasecmp(s.c_str(), "bzmpop") == 0) {
+        /* BLMPOP timeout numkeys key [key ...] LEFT|RIGHT */
+        secs = atof(args.front().c_str());
+    } else if (strcasecmp(s.c_str(), "wait") == 0 || strcasecmp(s.c_str(), "waitaof") == 0) {
+        /* WAIT numreplicas timeout */
+        long ms = atol(args.back().c_str());
+        return (ms > 0 && ms < INT_MAX) ? (int)ms : -1;
+    } else if (strcasecmp(s.c_str(), "xread") == 0 || strcasecmp(s.c_str(), "xreadgroup") == 0) {
+        /* XREAD [COUNT count] [BLOCK milliseconds] STREAMS key [key ...] id [id ...] */
+        for (size_t i = 0; i + 1 < args.size(); i++) {
+            if (strcasecmp(args[i].c_str(), "streams") == 0) {
+                break;
+            }
+            if (strcasecmp(args[i].c_str(), "block") == 0) {
+                long ms = atol(args[i + 1].c_str());
+                return (ms > 0 && ms < INT_MAX) ? (int)ms : -1;
+            }
+        }
+        return 0;
+    } else {
+        return 0;
+    }
+    return (secs > 0 && secs * 1000 < INT_MAX) ? (int)(secs * 1000) : -1;
+}
+
+bool RedisCluster::parse_redirect(const char* err, size_t len, const std::string& host,
+                                  bool* is_ask, int* slot, addr_t* addr) {
+    if (err == nullptr) {
+        return false;
+    }
+
+    std::string s(err, len);
+    if (s.compare(0, 6, "MOVED ") == 0) {
+        *is_ask = false;
+    } else if (s.compare(0, 4, "ASK ") == 0) {
+        *is_ask = true;
+    } else {
+        return false;
+    }
+
+    size_t pos = s.find(' ');
+    size_t addr_pos = s.find(' ', pos + 1);
+    size_t port_pos = s.rfind(':');
+    if (addr_pos == std::string::npos || port_pos == std::string::npos || port_pos < addr_pos) {
+        return false;
+    }
+
+    *slot = atoi(s.substr(pos + 1, addr_pos - pos - 1).c_str());
+    addr->host = s.substr(addr_pos + 1, port_pos - addr_pos - 1);
+    addr->port = atoi(s.substr(port_pos + 1).c_str());
+    if (addr->host.empty()) {
+        addr->host = host;
+    }
+    return (*slot >= 0 && *slot < SLOT_CNT && !addr->host.empty() && addr->port > 0);
+}
+
+const RedisCluster::addr_t& RedisCluster::owner(int slot) const {
+    if (slot >= 0 && slot < SLOT_CNT && m_slots[slot] >= 0) {
+        return m_masters[m_slots[slot]];
+    }
+    if (slot < 0 && !m_masters.empty()) {
+        return m_masters[0];
+    }
+    return m_seed;
+}
+
+int RedisCluster::master_index(const addr_t& addr) {
+    for (size_t i = 0; i < m_masters.size(); i++) {
+        if (m_masters[i].port == addr.port && m_masters[i].host == addr.host) {
+            return (int)i;
+        }
+    }
+    m_masters.push_back(addr);
+    return (int)m_masters.size() - 1;
+}
+
+void RedisCluster::set_owner(int slot, const addr_t& addr) {
+    if (slot >= 0 && slot < SLOT_CNT) {
+        m_slots[slot] = master_index(addr);
+    }
+}
+
+bool RedisCluster::update(const redisReply* r, const std::string& host) {
+    if (r == nullptr || r->type != REDIS_REPLY_ARRAY || r->elements == 0) {
+        return false;
+    }
+
+    std::vector<addr_t> masters;
+    std::vector<int> slots(SLOT_CNT, -1);
+
+    /* 1) 1) start slot 2) end slot 3) 1) master's host 2) master's port ... */
+    for (size_t i = 0; i < r->elements; i++) {
+        const redisReply* range = r->element[i];
+        if (range == nullptr || range->type != REDIS_REPLY_ARRAY || range->elements < 3 ||
+            range->element[0]->type != REDIS_REPLY_INTEGER ||
+            range->element[1]->type != REDIS_REPLY_INTEGER ||
+            range->element[2]->type != REDIS_REPLY_ARRAY ||
+            range->element[2]->elements < 2) {
+            return false;
+        }
+
+        const redisReply* node = range->element[2];
+        if (node->element[0]->type != REDIS_REPLY_STRING ||
+            node->element[1]->type != REDIS_REPLY_INTEGER) {
+            return false;
+        }
+
+        addr_t addr;
+        addr.host.assign(node->element[0]->str, node->element[0]->len);
+        addr.port = (int)node->element[1]->integer;
+        if (addr.host.empty() || addr.host == "?") {
+            addr.host = host;
+        }
+
+        int index = -1;
+        for (size_t j = 0; j < masters.size(); j++) {
+            if (masters[j].port == addr.port && masters[j].host == addr.host) {
+                index = (int)j;
+                break;
+            }
+        }
+        if (index < 0) {
+            masters.push_back(addr);
+            index = (int)masters.size() - 1;
+        }
+
+        long long start = range->element[0]->integer;
+        long long end = range->element[1]->integer;
+        for (long long slot = start; slot <= end && slot < SLOT_CNT; slot++) {
+            if (slot >= 0) {
+                slots[slot] = index;
+            }
+        }
+    }
+
+    m_masters.swap(masters);
+    m_slots.swap(slots);
+    m_is_ready = true;
+    return true;
+}
+
+}  // namespace kim
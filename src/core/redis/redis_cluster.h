@@ -0,0 +1,65 @@
+#pragma once
+
+#include <hiredis/hiredis.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+namespace kim {
+
+/**
+ * redis cluster's slot map, slot -> master's address.
+ * a key is mapped to slot CRC16(key) % 16384, if the key has a {hash tag},
+ * only the tag is hashed, so the related keys can be kept in one slot.
+ */
+class RedisCluster {
+   public:
+    static const int SLOT_CNT = 16384;
+
+    /* master's address. */
+    typedef struct addr_s {
+        std::string host;
+        int port = 0;
+    } addr_t;
+
+    RedisCluster(const std::string& host, int port);
+    virtual ~RedisCluster() {}
+
+    /* slot of the key. */
+    static int key_slot(const char* key, size_t len);
+    /* the key of an encoded cmd (RESP): the first argument, or the first key
+     * of EVAL/EVALSHA. false: the cmd has no key (PING...). */
+    static bool cmd_key(const char* cmd, size_t len, const char** key, size_t* key_len);
+    /* how long a blocking cmd may wait on server before replying (ms):
+     * BLPOP...'s timeout (seconds), XREAD's BLOCK, WAIT's timeout.
+     * 0: not a blocking cmd, -1: blocks without timeout. */
+    static int cmd_block_time(const char* cmd, size_t len);
+    /* "MOVED 3999 127.0.0.1:6381" or "ASK 3999 127.0.0.1:6381",
+     * host: the replying node's host, for the address without host ("MOVED 3999 :6381"). */
+    static bool parse_redirect(const char* err, size_t len, const std::string& host,
+                               bool* is_ask, int* slot, addr_t* addr);
+
+    /* master of the slot, the seed node if the slot is unknown, slot < 0: any master. */
+    const addr_t& owner(int slot) const;
+    void set_owner(int slot, const addr_t& addr);
+    const std::vector<addr_t>& masters() const { return m_masters; }
+    const addr_t& seed() const { return m_seed; }
+    bool is_ready() const { return m_is_ready; }
+
+    /* rebuild the map with CLUSTER SLOTS' reply,
+     * host: the replying node's host, for the masters which have no host. */
+    bool update(const redisReply* r, const std::string& host);
+
+   private:
+    int master_index(const addr_t& addr);
+
+   private:
+    addr_t m_seed;                 /* the node in config. */
+    bool m_is_ready = false;       /* the map has been loaded from CLUSTER SLOTS. */
+    std::vector<addr_t> m_masters; /* known masters. */
+    std::vector<int> m_slots;      /* slot -> index of m_masters, -1: unknown. */
+};
+
+}  // namespace kim
@@ -2,12 +2,19 @@
 
 #include <hiredis/hiredis.h>
 #include <stdarg.h>
+#include <strings.h>
+#include <sys/socket.h>
 
 #include "error.h"
 
 const int MAX_CONN_CNT = 10;
-const int PIPELINE_CMD_CNT = 100;
+const int PIPELINE_CMD_CNT = 100; /* cmds appended per write, and a conn with more in-flight cmds is busy. */
 const int TASKS_QUEUE_LIMIT = 100000;
+const int IO_TIME_OUT = 3000;     /* connecting, sending, and the default of waiting for replies. */
+const int MAX_REDIRECT_CNT = 5;
+const int CLUSTER_REFRESH_INTERVAL = 60 * 1000; /* refresh cluster's slots periodically. */
+const int CLUSTER_REFRESH_MIN_INTERVAL = 1000;  /* MOVED or conn errors refresh slots at most once a second. */
+const int CACHE_MAX_MEMORY = 64;                /* client side cache's default memory limit (MB). */
 
 namespace kim {
 
@@ -23,12 +30,234 @@ int RedisMgr::exec_cmd(const std::string& node, const std::string& cmd, redisRep
         LOG_ERROR("invalid params!");
         return ERR_INVALID_PARAMS;
     }
-    return send_task(node, cmd, r);
-}
 
-int RedisMgr::send_task(const std::string& node, const std::string& cmd, redisReply** r) {
+    /* encode the cmd in the caller's coroutine, the data it refers to
+     * may be on a shared stack which is not valid in other coroutines. */
+    auto task = std::make_shared<task_t>();
+    task->cmd_len = redisFormatCommand(&task->cmd, cmd.c_str());
+    if (task->cmd_len < 0) {
+        task->cmd = nullptr;
+        LOG_ERROR("format redis cmd failed! cmd: %s", cmd.c_str());
+        return ERR_REDIS_APPEND_CMD_FAILED;
+    }
+
     LOG_DEBUG("send redis task, node: %s, cmd: %s.", node.c_str(), cmd.c_str());
+    return send_task(node, task, r);
+}
+
+int RedisMgr::exec_cmd_argv(const std::string& node, int argc,
+                            const char** argv, const size_t* argvlen, redisReply** r) {
+    if (node.empty() || argc <= 0 || argv == nullptr || argvlen == nullptr) {
+        LOG_ERROR("invalid params!");
+        return ERR_INVALID_PARAMS;
+    }
+
+    auto task = format_task(argc, argv, argvlen);
+    if (task == nullptr) {
+        LOG_ERROR("format redis cmd failed! argc: %d", argc);
+        return ERR_REDIS_APPEND_CMD_FAILED;
+    }
+
+    LOG_DEBUG("send redis task, node: %s, cmd: %.*s, argc: %d.",
+              node.c_str(), (int)argvlen[0], argv[0], argc);
+    return send_task(node, task, r);
+}
+
+int RedisMgr::exec_cmds(const std::string& node, const std::vector<std::vector<RedisArg>>& cmds,
+                        std::vector<redisReply*>& replies) {
+    replies.assign(cmds.size(), nullptr);
+    if (node.empty() || cmds.empty()) {
+        LOG_ERROR("invalid params!");
+        return ERR_INVALID_PARAMS;
+    }
+
+    std::shared_ptr<cluster_data_t> cl = nullptr;
+    auto it = m_clusters.find(node);
+    if (it != m_clusters.end()) {
+        cl = it->second;
+        if (!cl->slots->is_ready()) {
+            refresh_cluster(cl);
+        }
+    }
+
+    /* encode all cmds in the caller's coroutine. */
+    std::vector<std::shared_ptr<task_t>> tasks;
+    std::vector<const char*> argv;
+    std::vector<size_t> argvlen;
+    for (const auto& args : cmds) {
+        argv.clear();
+        argvlen.clear();
+        for (const auto& arg : args) {
+            argv.push_back(arg.data());
+            argvlen.push_back(arg.size());
+        }
+        auto task = args.empty() ? nullptr : format_task((int)args.size(), argv.data(), argvlen.data());
+        if (task == nullptr) {
+            LOG_ERROR("format redis cmd failed! node: %s, index: %lu", node.c_str(), tasks.size());
+            return ERR_REDIS_APPEND_CMD_FAILED;
+        }
+        tasks.push_back(task);
+    }
+
+    /* the writes' keys are dropped from the cache before and after, as send_task does. */
+    std::shared_ptr<cache_data_t> ca = nullptr;
+    auto itc = m_caches.find(node);
+    if (itc != m_caches.end()) {
+        ca = itc->second;
+        for (auto& task : tasks) {
+            ca->cache->invalidate_cmd(task->cmd, task->cmd_len);
+        }
+    }
+
+    /* the cmds are pipelined in the order, in a cluster, every master's
+     * conn gets its own part. 1 pending for pushing, which may sleep. */
+    auto batch = std::make_shared<batch_t>();
+    batch->co = co_self();
+    batch->pending = 1;
+
+    for (auto& task : tasks) {
+        task->batch = batch;
+        task->is_cluster = (cl != nullptr);
+        auto pool = (cl != nullptr) ? cluster_pool(cl, cl->slots->owner(cluster_task_slot(task))) : node;
+        int ret = push_task(pool, task);
+        if (ret != ERR_OK) {
+            task->batch = nullptr;
+            task->ret = ret;
+            continue;
+        }
+        batch->pending++;
+    }
+
+    if (--batch->pending > 0) {
+        co_yield_ct();
+    }
+    m_write_seqs[node]++;
+    if (ca != nullptr) {
+        for (auto& task : tasks) {
+            ca->cache->invalidate_cmd(task->cmd, task->cmd_len);
+        }
+    }
+
+    int ret = ERR_OK;
+    for (size_t i = 0; i < tasks.size(); i++) {
+        auto& task = tasks[i];
+        task->batch = nullptr;
+        if (cl != nullptr) {
+            redirect_cluster_task(cl, task);
+        }
+        replies[i] = task->reply;
+        if (task->ret != ERR_OK && ret == ERR_OK) {
+            ret = task->ret;
+        }
+    }
+    return ret;
+}
+
+std::shared_ptr<RedisMgr::task_t>
+RedisMgr::format_task(int argc, const char** argv, const size_t* argvlen) {
+    auto task = std::make_shared<task_t>();
+    task->cmd_len = redisFormatCommandArgv(&task->cmd, argc, argv, argvlen);
+    if (task->cmd_len < 0) {
+        task->cmd = nullptr;
+        return nullptr;
+    }
+    return task;
+}
+
+int RedisMgr::send_task(const std::string& node, std::shared_ptr<task_t> task, redisReply** r) {
+    auto it = m_clusters.find(node);
+    if (it != m_clusters.end()) {
+        return send_cluster_task(it->second, task, r);
+    }
+
+    std::string key;
+    if (RedisCache::is_cacheable(task->cmd, task->cmd_len, key)) {
+        auto itc = m_caches.find(node);
+        if (itc != m_caches.end()) {
+            return send_cached_task(itc->second, node, key, task, r);
+        }
+        return send_read_task(node, task, r);
+    }
+
+    /* the fills in flight may read the old value, and the ones sent while
+     * the write is in flight may cache it, so its keys are dropped twice. */
+    std::shared_ptr<cache_data_t> ca = nullptr;
+    auto itc = m_caches.find(node);
+    if (itc != m_caches.end()) {
+        ca = itc->second;
+        ca->cache->invalidate_cmd(task->cmd, task->cmd_len);
+    }
+
+    task->co = co_self();
+    int ret = push_task(node, task);
+    if (ret != ERR_OK) {
+        return ret;
+    }
+    co_yield_ct();
+    m_write_seqs[node]++;
+    if (ca != nullptr) {
+        ca->cache->invalidate_cmd(task->cmd, task->cmd_len);
+    }
+
+    *r = task->reply;
+    return task->ret;
+}
+
+int RedisMgr::send_read_task(const std::string& node, std::shared_ptr<task_t> task, redisReply** r) {
+    std::string fkey(node);
+    fkey.push_back('\0');
+    fkey.append(task->cmd, task->cmd_len);
+
+    uint64_t write_seq = m_write_seqs[node];
+    auto it = m_flights.find(fkey);
+    if (it != m_flights.end() && it->second->write_seq == write_seq) {
+        /* an identical read is in flight, wait for its reply. */
+        auto fl = it->second;
+        fl->followers.push_back(co_self());
+        co_yield_ct();
+
+        *r = nullptr;
+        if (fl->reply != nullptr) {
+            *r = RedisCache::copy_reply(fl->reply);
+            if (*r == nullptr) {
+                return ERR_REDIS_GET_REPLY_FAILED;
+            }
+        }
+        return fl->ret;
+    }
+
+    /* the read in flight (if any) may miss the writes done after it was sent,
+     * the later reads share this one instead. */
+    auto fl = std::make_shared<flight_t>();
+    fl->write_seq = write_seq;
+    m_flights[fkey] = fl;
+
+    task->co = co_self();
+    int ret = push_task(node, task);
+    if (ret == ERR_OK) {
+        co_yield_ct();
+        ret = task->ret;
+    }
+    it = m_flights.find(fkey);
+    if (it != m_flights.end() && it->second == fl) {
+        m_flights.erase(it);
+    }
+
+    fl->ret = ret;
+    fl->reply = task->reply;
+    if (!fl->followers.empty()) {
+        LOG_TRACE("redis read coalesced! node: %s, followers: %lu",
+                  node.c_str(), fl->followers.size());
+        for (auto co : fl->followers) {
+            co_resume(co);
+        }
+    }
+
+    *r = task->reply;
+    return ret;
+}
 
+int RedisMgr::push_task(const std::string& node, std::shared_ptr<task_t> task, bool is_asking) {
     std::shared_ptr<co_data_t> cd = nullptr;
 
     for (int i = 0; i < 3; i++) {
@@ -37,30 +266,52 @@ int RedisMgr::send_task(const std::string& node, const std::string& cmd, redisRe
             LOG_ERROR("can not find conn, node: %s", node.c_str());
             return ERR_REDIS_NO_CONNCTION;
         }
-        if (cd->tasks.size() > TASKS_QUEUE_LIMIT) {
+        if (cd->tasks.size() + cd->waiting.size() > TASKS_QUEUE_LIMIT) {
             co_sleep(1000);
             continue;
         }
         break;
     }
 
-    if (cd->tasks.size() > TASKS_QUEUE_LIMIT) {
+    if (cd->tasks.size() + cd->waiting.size() > TASKS_QUEUE_LIMIT) {
         LOG_WARN("redis task over limit! node: %s.", node.c_str());
         return ERR_REDIS_TASKS_OVER_LIMIT;
     }
 
-    auto task = std::make_shared<task_t>();
-    task->cmd = cmd;
-    task->co = co_self();
+    if (is_asking) {
+        /* ASK redirection, ASKING must be sent just before the cmd on the same conn. */
+        const char* argv[] = {"ASKING"};
+        const size_t argvlen[] = {6};
+        auto asking = format_task(1, argv, argvlen);
+        if (asking == nullptr) {
+            return ERR_REDIS_APPEND_CMD_FAILED;
+        }
+        cd->tasks.push(asking);
+    }
+
+    task->block_time = RedisCluster::cmd_block_time(task->cmd, task->cmd_len);
+
     cd->tasks.push(task);
 
     co_cond_signal(cd->cond);
     LOG_TRACE("signal redis co handler! node: %s, co: %p", node.c_str(), cd->co);
-    co_yield_ct();
+    return ERR_OK;
+}
 
-    auto ret = task->ret;
-    *r = task->reply;
-    return ret;
+void RedisMgr::resume_task(std::shared_ptr<task_t> task) {
+    if (task->batch != nullptr) {
+        if (--task->batch->pending == 0) {
+            co_resume(task->batch->co);
+        }
+        return;
+    }
+
+    if (task->co == nullptr) {
+        freeReplyObject(task->reply);
+        task->reply = nullptr;
+        return;
+    }
+    co_resume(task->co);
 }
 
 std::shared_ptr<RedisMgr::co_data_t>
@@ -80,12 +331,18 @@ RedisMgr::get_co_data(const std::string& node) {
         ad->ri = it->second;
         m_coroutines[node] = ad;
     } else {
+        /* pick the least loaded conn, one conn pipelines many cmds,
+         * open another one only if all of them are busy. */
         ad = itr->second;
-        if ((int)ad->coroutines.size() >= ad->ri->max_conn_cnt) {
-            auto cd = ad->coroutines[ad->cur_idx % ad->coroutines.size()];
-            if (++ad->cur_idx == (int)ad->coroutines.size()) {
-                ad->cur_idx = 0;
+        for (auto& c : ad->coroutines) {
+            if (cd == nullptr || (c->tasks.size() + c->waiting.size()) <
+                                     (cd->tasks.size() + cd->waiting.size())) {
+                cd = c;
             }
+        }
+        if (cd != nullptr &&
+            ((int)ad->coroutines.size() >= ad->ri->max_conn_cnt ||
+             (int)(cd->tasks.size() + cd->waiting.size()) < PIPELINE_CMD_CNT)) {
             return cd;
         }
     }
@@ -94,12 +351,20 @@ RedisMgr::get_co_data(const std::string& node) {
     cd->ri = it->second;
     cd->privdata = this;
     cd->cond = co_cond_alloc();
+    cd->reader_cond = co_cond_alloc();
+
+    auto itc = m_caches.find(node);
+    if (itc != m_caches.end()) {
+        cd->ca = itc->second;
+    }
 
     ad->coroutines.push_back(cd);
 
-    LOG_INFO("node: %s, co cnt: %d, max conn cnt: %d, %d",
+    LOG_INFO("node: %s, co cnt: %d, max conn cnt: %d",
              node.c_str(), (int)ad->coroutines.size(), ad->ri->max_conn_cnt);
 
+    co_create(&(cd->reader_co), nullptr, [this, cd](void*) { on_handle_reply(cd); });
+    co_resume(cd->reader_co);
     co_create(&(cd->co), nullptr, [this, cd](void*) { on_handle_task(cd); });
     co_resume(cd->co);
     return cd;
@@ -109,6 +374,10 @@ void RedisMgr::on_handle_task(std::shared_ptr<co_data_t> cd) {
     co_enable_hook_sys();
 
     for (;;) {
+        if (cd->c != nullptr && cd->is_broken) {
+            close_conn(cd);
+        }
+
         if (cd->tasks.empty()) {
             LOG_TRACE("no redis task, pls wait! node: %s, co: %p",
                       cd->ri->node.c_str(), cd->co);
@@ -117,8 +386,7 @@ void RedisMgr::on_handle_task(std::shared_ptr<co_data_t> cd) {
         }
 
         if (cd->c == nullptr) {
-            cd->c = connect(cd->ri->host.c_str(), cd->ri->port);
-            if (cd->c == nullptr) {
+            if (!connect(cd)) {
                 LOG_ERROR("connect redis failed! node: %s, host: %s, port: %d",
                           cd->ri->node.c_str(), cd->ri->host.c_str(), cd->ri->port);
                 clear_co_tasks(cd);
@@ -130,61 +398,188 @@ void RedisMgr::on_handle_task(std::shared_ptr<co_data_t> cd) {
                      cd->ri->host.c_str(), cd->ri->port);
         }
 
-        handle_redis_cmd(cd);
-
-        if (cd->c->err != REDIS_OK) {
-            redisFree(cd->c);
-            cd->c = nullptr;
+        /* stream the cmds, the tasks which arrive while the writer
+         * is sending are appended in the next round. */
+        if (!append_redis_cmds(cd) || !flush_redis_cmds(cd)) {
+            set_conn_error(cd, "send cmds failed");
         }
     }
 }
 
-void RedisMgr::handle_redis_cmd(std::shared_ptr<co_data_t> cd) {
+bool RedisMgr::append_redis_cmds(std::shared_ptr<co_data_t> cd) {
     int i = 0;
-    bool is_reply_ok = true;
-    std::list<std::shared_ptr<task_t>> tasks;
 
-    /* for pipeline */
+    /* a new conn, or the invalidation conn has been reconnected. */
+    if (cd->ca != nullptr && cd->ca->client_id != 0 &&
+        cd->tracking_sent != cd->ca->client_id && !append_tracking_cmd(cd)) {
+        return false;
+    }
+
     while (i++ < PIPELINE_CMD_CNT && !cd->tasks.empty()) {
         auto task = cd->tasks.front();
         cd->tasks.pop();
-        LOG_DEBUG("append redis cmd: %s", task->cmd.c_str());
+        LOG_DEBUG("append redis cmd, len: %d", task->cmd_len);
 
-        auto ret = redisAppendCommand(cd->c, task->cmd.c_str());
+        auto ret = redisAppendFormattedCommand(cd->c, task->cmd, task->cmd_len);
         if (ret == REDIS_OK) {
-            tasks.push_back(task);
+            if (cd->waiting.empty()) {
+                cd->reply_time = co_tick_ms();
+            }
+            cd->waiting.push(task);
         } else {
-            LOG_ERROR("redis append cmd failed! cmd: %s, err: %d, node: %s, host: %s, port: %d",
-                      task->cmd.c_str(), ret,
+            LOG_ERROR("redis append cmd failed! len: %d, err: %d, node: %s, host: %s, port: %d",
+                      task->cmd_len, ret,
                       cd->ri->node.c_str(), cd->ri->host.c_str(), cd->ri->port);
             task->ret = ERR_REDIS_APPEND_CMD_FAILED;
-            co_resume(task->co);
+            resume_task(task);
+            if (cd->c->err != REDIS_OK) {
+                return false;
+            }
         }
     }
 
-    for (const auto& task : tasks) {
-        auto ret = redisGetReply(cd->c, (void**)&task->reply);
-        if (ret != REDIS_OK || cd->c->err != REDIS_OK) {
-            is_reply_ok = false;
-            LOG_ERROR("redis get reply failed! err: %d, errstr: %s, node: %s, host: %s, port: %d",
-                      cd->c->err, cd->c->errstr,
-                      cd->ri->node.c_str(), cd->ri->host.c_str(), cd->ri->port);
-        } else if ((task->reply != nullptr) && (task->reply->type == REDIS_REPLY_ERROR)) {
-            is_reply_ok = false;
-            LOG_ERROR("redis get reply failed! err: %d, errstr: %s, node: %s, host: %s, port: %d",
-                      task->reply->type, task->reply->str,
-                      cd->ri->node.c_str(), cd->ri->host.c_str(), cd->ri->port);
+    if (!cd->waiting.empty()) {
+        co_cond_signal(cd->reader_cond);
+    }
+    return true;
+}
+
+bool RedisMgr::flush_redis_cmds(std::shared_ptr<co_data_t> cd) {
+    int done = 0;
+
+    while (!done) {
+        errno = 0;
+        if (cd->is_broken || redisBufferWrite(cd->c, &done) != REDIS_OK) {
+            return false;
+        }
+        if (!done && errno == EAGAIN) {
+            /* socket's send buffer is full, wait for next edge. */
+            co_fd_event_clear(cd->ev, POLLOUT);
+            if (co_fd_event_wait(cd->ev, POLLOUT, IO_TIME_OUT) <= 0) {
+                return false;
+            }
         }
+    }
+    return true;
+}
+
+void RedisMgr::on_handle_reply(std::shared_ptr<co_data_t> cd) {
+    co_enable_hook_sys();
 
-        if (!is_reply_ok) {
-            freeReplyObject(task->reply);
-            task->reply = nullptr;
-            task->ret = ERR_REDIS_GET_REPLY_FAILED;
+    for (;;) {
+        if (cd->c == nullptr || cd->is_broken || cd->waiting.empty()) {
+            co_cond_timedwait(cd->reader_cond, -1);
+            continue;
+        }
+
+        redisReply* reply = nullptr;
+        if (redisGetReplyFromReader(cd->c, (void**)&reply) != REDIS_OK) {
+            set_conn_error(cd, "parse reply failed");
+            continue;
+        }
+
+        if (reply != nullptr) {
+            handle_redis_reply(cd, reply);
+            continue;
+        }
+
+        errno = 0;
+        if (redisBufferRead(cd->c) != REDIS_OK) {
+            set_conn_error(cd, "read reply failed");
+            continue;
         }
+
+        if (errno == EAGAIN) {
+            /* drained, wait for next edge. */
+            co_fd_event_clear(cd->ev, POLLIN);
+            int timeout = reply_timeout(cd);
+            int ret = co_fd_event_wait(cd->ev, POLLIN, timeout);
+            if (ret == 0 && timeout >= 0 && cd->c != nullptr && !cd->waiting.empty() &&
+                reply_timeout(cd) == 0) {
+                set_conn_error(cd, "wait for reply timeout");
+            }
+        }
+    }
+}
+
+int RedisMgr::reply_timeout(std::shared_ptr<co_data_t> cd) {
+    /* the replies come in order, so the oldest cmd's reply is waited for,
+     * the timer restarts whenever a reply arrives. */
+    int block_time = cd->waiting.empty() ? 0 : cd->waiting.front()->block_time;
+    if (block_time < 0) {
+        return -1;
+    }
+    uint64_t deadline = cd->reply_time + cd->ri->reply_timeout + block_time;
+    uint64_t now = co_tick_ms();
+    return (now >= deadline) ? 0 : (int)(deadline - now);
+}
+
+void RedisMgr::handle_redis_reply(std::shared_ptr<co_data_t> cd, redisReply* reply) {
+    auto task = cd->waiting.front();
+    cd->waiting.pop();
+    cd->reply_time = co_tick_ms();
+    task->reply = reply;
+
+    bool is_ask = false;
+    int slot = 0;
+    RedisCluster::addr_t addr;
+
+    if (task->is_tracking) {
+        if (reply->type != REDIS_REPLY_ERROR) {
+            cd->tracking_id = task->tracking_id;
+        }
+    } else {
+        /* the conn's reads after the tracking cmd are tracked. */
+        task->tracking_id = cd->tracking_id;
+    }
+
+    if (reply->type == REDIS_REPLY_ERROR && task->is_cluster &&
+        RedisCluster::parse_redirect(reply->str, reply->len, cd->ri->host, &is_ask, &slot, &addr)) {
+        /* the caller follows the redirection. */
+        task->ret = ERR_REDIS_CLUSTER_REDIRECT;
+        task->host = cd->ri->host;
+    } else if (reply->type == REDIS_REPLY_ERROR) {
+        LOG_ERROR("redis get reply failed! err: %d, errstr: %s, node: %s, host: %s, port: %d",
+                  reply->type, reply->str,
+                  cd->ri->node.c_str(), cd->ri->host.c_str(), cd->ri->port);
+        freeReplyObject(task->reply);
+        task->reply = nullptr;
+        task->ret = ERR_REDIS_GET_REPLY_FAILED;
+    }
+
+    resume_task(task);
+}
+
+void RedisMgr::set_conn_error(std::shared_ptr<co_data_t> cd, const char* reason) {
+    if (cd->is_broken) {
+        return;
     }
 
-    for (const auto& task : tasks) {
-        co_resume(task->co);
+    LOG_ERROR("redis conn error: %s! err: %d, errstr: %s, node: %s, host: %s, port: %d",
+              reason, cd->c->err, cd->c->errstr,
+              cd->ri->node.c_str(), cd->ri->host.c_str(), cd->ri->port);
+
+    /* the writer closes the conn, the reader may be waiting for replies. */
+    cd->is_broken = true;
+    co_cond_signal(cd->cond);
+}
+
+void RedisMgr::close_conn(std::shared_ptr<co_data_t> cd) {
+    /* wake up the coroutines which are waiting on the fd. */
+    co_fd_event_free(cd->ev);
+    cd->ev = nullptr;
+    redisFree(cd->c);
+    cd->c = nullptr;
+    cd->is_broken = false;
+    cd->tracking_sent = 0;
+    cd->tracking_id = 0;
+
+    /* the replies of the sent cmds are lost. */
+    while (!cd->waiting.empty()) {
+        auto task = cd->waiting.front();
+        cd->waiting.pop();
+        task->ret = ERR_REDIS_GET_REPLY_FAILED;
+        resume_task(task);
     }
 }
 
@@ -193,10 +588,336 @@ void RedisMgr::clear_co_tasks(std::shared_ptr<co_data_t> cd) {
         auto task = cd->tasks.front();
         cd->tasks.pop();
         task->ret = ERR_REDIS_TASKS_CLEAR;
-        co_resume(task->co);
+        resume_task(task);
+    }
+}
+
+int RedisMgr::cluster_task_slot(std::shared_ptr<task_t> task) {
+    const char* key = nullptr;
+    size_t len = 0;
+    if (!RedisCluster::cmd_key(task->cmd, task->cmd_len, &key, &len)) {
+        return -1;
+    }
+    return RedisCluster::key_slot(key, len);
+}
+
+std::string RedisMgr::cluster_pool(std::shared_ptr<cluster_data_t> cl, const RedisCluster::addr_t& addr) {
+    std::string node = format_str("%s@%s:%d", cl->ri->node.c_str(), addr.host.c_str(), addr.port);
+    if (m_rds_infos.find(node) == m_rds_infos.end()) {
+        auto ri = std::make_shared<redis_info_t>();
+        ri->node = node;
+        ri->host = addr.host;
+        ri->port = addr.port;
+        ri->max_conn_cnt = cl->ri->max_conn_cnt;
+        ri->reply_timeout = cl->ri->reply_timeout;
+        m_rds_infos[node] = ri;
+        LOG_INFO("add redis cluster node: %s", node.c_str());
+    }
+    return node;
+}
+
+int RedisMgr::send_cluster_task(std::shared_ptr<cluster_data_t> cl,
+                                std::shared_ptr<task_t> task, redisReply** r) {
+    if (!cl->slots->is_ready()) {
+        refresh_cluster(cl);
+    }
+
+    task->is_cluster = true;
+    task->co = co_self();
+    auto pool = cluster_pool(cl, cl->slots->owner(cluster_task_slot(task)));
+    int ret = push_task(pool, task);
+    if (ret != ERR_OK) {
+        refresh_cluster(cl);
+        return ret;
+    }
+    co_yield_ct();
+
+    ret = redirect_cluster_task(cl, task);
+    *r = task->reply;
+    return ret;
+}
+
+int RedisMgr::redirect_cluster_task(std::shared_ptr<cluster_data_t> cl, std::shared_ptr<task_t> task) {
+    for (int i = 0; task->ret == ERR_REDIS_CLUSTER_REDIRECT; i++) {
+        bool is_ask = false;
+        int slot = 0;
+        RedisCluster::addr_t addr;
+
+        bool ok = RedisCluster::parse_redirect(
+            task->reply->str, task->reply->len, task->host, &is_ask, &slot, &addr);
+        LOG_DEBUG("redis cluster redirect: %s, node: %s", task->reply->str, cl->ri->node.c_str());
+        freeReplyObject(task->reply);
+        task->reply = nullptr;
+
+        if (!ok || i >= MAX_REDIRECT_CNT) {
+            LOG_ERROR("redis cluster redirect failed! node: %s, cnt: %d", cl->ri->node.c_str(), i);
+            task->ret = ERR_REDIS_CLUSTER_REDIRECT_FAILED;
+            refresh_cluster(cl);
+            break;
+        }
+
+        /* MOVED: the slot has been moved, ASK: the slot is being migrated,
+         * only this cmd goes to the new node. */
+        if (!is_ask) {
+            cl->slots->set_owner(slot, addr);
+            refresh_cluster(cl);
+        }
+
+        task->ret = ERR_OK;
+        task->co = co_self();
+        int ret = push_task(cluster_pool(cl, addr), task, is_ask);
+        if (ret != ERR_OK) {
+            task->ret = ret;
+            break;
+        }
+        co_yield_ct();
+    }
+
+    /* the master may be down, the slots are taken over by its replica. */
+    if (task->ret == ERR_REDIS_TASKS_CLEAR ||
+        (task->ret == ERR_REDIS_GET_REPLY_FAILED && task->reply == nullptr)) {
+        refresh_cluster(cl);
+    }
+    return task->ret;
+}
+
+void RedisMgr::refresh_cluster(std::shared_ptr<cluster_data_t> cl) {
+    cl->need_refresh = true;
+    if (cl->co == nullptr) {
+        co_create(&(cl->co), nullptr, [this, cl](void*) { on_refresh_cluster(cl); });
+        co_resume(cl->co);
+        return;
+    }
+    co_cond_signal(cl->cond);
+}
+
+void RedisMgr::on_refresh_cluster(std::shared_ptr<cluster_data_t> cl) {
+    co_enable_hook_sys();
+
+    for (;;) {
+        if (!cl->need_refresh) {
+            /* refresh periodically if no one asks. */
+            co_cond_timedwait(cl->cond, CLUSTER_REFRESH_INTERVAL);
+        }
+        cl->need_refresh = false;
+
+        uint64_t now = co_tick_ms();
+        if (cl->refresh_time != 0 && now < cl->refresh_time + CLUSTER_REFRESH_MIN_INTERVAL) {
+            co_sleep(cl->refresh_time + CLUSTER_REFRESH_MIN_INTERVAL - now);
+        }
+
+        load_cluster_slots(cl);
+        cl->refresh_time = co_tick_ms();
+    }
+}
+
+void RedisMgr::load_cluster_slots(std::shared_ptr<cluster_data_t> cl) {
+    /* ask the known masters, then the seed. */
+    auto addrs = cl->slots->masters();
+    addrs.push_back(cl->slots->seed());
+
+    for (const auto& addr : addrs) {
+        redisReply* reply = nullptr;
+        int ret = exec_cmd_args(cluster_pool(cl, addr), &reply, "CLUSTER", "SLOTS");
+        if (ret == ERR_OK && cl->slots->update(reply, addr.host)) {
+            LOG_INFO("redis cluster slots refreshed! node: %s, from: %s:%d, masters: %lu",
+                     cl->ri->node.c_str(), addr.host.c_str(), addr.port, cl->slots->masters().size());
+            freeReplyObject(reply);
+            return;
+        }
+        freeReplyObject(reply);
+    }
+
+    LOG_ERROR("refresh redis cluster slots failed! node: %s", cl->ri->node.c_str());
+}
+
+int RedisMgr::send_cached_task(std::shared_ptr<cache_data_t> ca, const std::string& node,
+                               const std::string& key, std::shared_ptr<task_t> task, redisReply** r) {
+    if (ca->co == nullptr) {
+        co_create(&(ca->co), nullptr, [this, ca](void*) { on_invalidation(ca); });
+        co_resume(ca->co);
+    }
+
+    /* the cache is valid only while the invalidation conn is alive. */
+    if (ca->client_id != 0) {
+        redisReply* reply = ca->cache->get(task->cmd, task->cmd_len);
+        if (reply != nullptr) {
+            *r = reply;
+            return ERR_OK;
+        }
+    }
+
+    uint64_t ticket = ca->cache->begin_fill(key);
+    int ret = send_read_task(node, task, r);
+    bool is_valid = ca->cache->end_fill(key, ticket);
+
+    /* the key must be tracked by the current invalidation conn,
+     * only the leader of the coalesced reads has sent the cmd. */
+    if (is_valid && ret == ERR_OK &&
+        task->tracking_id != 0 && task->tracking_id == ca->client_id) {
+        ca->cache->set(key, task->cmd, task->cmd_len, *r);
+    }
+    return ret;
+}
+
+bool RedisMgr::append_tracking_cmd(std::shared_ptr<co_data_t> cd) {
+    /* RESP2: the invalidation messages are sent to the invalidation conn. */
+    char id[32];
+    snprintf(id, sizeof(id), "%lld", cd->ca->client_id);
+    const char* argv[] = {"CLIENT", "TRACKING", "on", "REDIRECT", id};
+    const size_t argvlen[] = {6, 8, 2, 8, strlen(id)};
+
+    auto task = format_task(5, argv, argvlen);
+    if (task == nullptr) {
+        return false;
+    }
+    task->is_tracking = true;
+    task->tracking_id = cd->ca->client_id;
+
+    if (redisAppendFormattedCommand(cd->c, task->cmd, task->cmd_len) != REDIS_OK) {
+        LOG_ERROR("redis append tracking cmd failed! node: %s", cd->ri->node.c_str());
+        return false;
+    }
+
+    cd->waiting.push(task);
+    cd->tracking_sent = task->tracking_id;
+    return true;
+}
+
+bool RedisMgr::connect_invalidation(std::shared_ptr<cache_data_t> ca) {
+    stCoFdEvent_t* ev = nullptr;
+    redisContext* c = connect(ca->ri->host, ca->ri->port, &ev);
+    if (c == nullptr) {
+        return false;
+    }
+
+    /* the conn waits for messages without timeout, keepalive finds the dead peer. */
+    redisEnableKeepAlive(c);
+    redisAppendCommand(c, "CLIENT ID");
+    redisAppendCommand(c, "SUBSCRIBE __redis__:invalidate");
+
+    int done = 0;
+    bool ok = true;
+    while (ok && !done) {
+        errno = 0;
+        if (redisBufferWrite(c, &done) != REDIS_OK) {
+            ok = false;
+        } else if (!done && errno == EAGAIN) {
+            co_fd_event_clear(ev, POLLOUT);
+            ok = (co_fd_event_wait(ev, POLLOUT, IO_TIME_OUT) > 0);
+        }
+    }
+
+    long long client_id = 0;
+    redisReply* reply = ok ? read_reply(c, ev, IO_TIME_OUT) : nullptr;
+    if (reply != nullptr && reply->type == REDIS_REPLY_INTEGER) {
+        client_id = reply->integer;
+    }
+    freeReplyObject(reply);
+
+    reply = (client_id != 0) ? read_reply(c, ev, IO_TIME_OUT) : nullptr;
+    ok = (reply != nullptr && reply->type == REDIS_REPLY_ARRAY);
+    freeReplyObject(reply);
+
+    if (!ok) {
+        LOG_ERROR("redis invalidation conn init failed! node: %s, err: %d, errstr: %s",
+                  ca->ri->node.c_str(), c->err, c->errstr);
+        co_fd_event_free(ev);
+        redisFree(c);
+        return false;
+    }
+
+    ca->c = c;
+    ca->ev = ev;
+    ca->client_id = client_id;
+    LOG_INFO("redis invalidation conn done! node: %s, client id: %lld",
+             ca->ri->node.c_str(), client_id);
+    return true;
+}
+
+redisReply* RedisMgr::read_reply(redisContext* c, stCoFdEvent_t* ev, int timeout) {
+    for (;;) {
+        redisReply* reply = nullptr;
+        if (redisGetReplyFromReader(c, (void**)&reply) != REDIS_OK) {
+            return nullptr;
+        }
+        if (reply != nullptr) {
+            return reply;
+        }
+
+        errno = 0;
+        if (redisBufferRead(c) != REDIS_OK) {
+            return nullptr;
+        }
+        if (errno == EAGAIN) {
+            co_fd_event_clear(ev, POLLIN);
+            if (co_fd_event_wait(ev, POLLIN, timeout) <= 0) {
+                return nullptr;
+            }
+        }
     }
 }
 
+void RedisMgr::handle_invalidation(std::shared_ptr<cache_data_t> ca, redisReply* reply) {
+    /* 1) "message" 2) "__redis__:invalidate" 3) keys, nil: FLUSHALL/FLUSHDB. */
+    if (reply->type != REDIS_REPLY_ARRAY || reply->elements != 3 ||
+        reply->element[0]->type != REDIS_REPLY_STRING ||
+        strcasecmp(reply->element[0]->str, "message") != 0) {
+        return;
+    }
+
+    const redisReply* keys = reply->element[2];
+    if (keys->type != REDIS_REPLY_ARRAY) {
+        ca->cache->clear();
+        return;
+    }
+
+    for (size_t i = 0; i < keys->elements; i++) {
+        if (keys->element[i]->type == REDIS_REPLY_STRING) {
+            ca->cache->invalidate(keys->element[i]->str, keys->element[i]->len);
+        }
+    }
+}
+
+void RedisMgr::on_invalidation(std::shared_ptr<cache_data_t> ca) {
+    co_enable_hook_sys();
+
+    for (;;) {
+        if (ca->c == nullptr && !connect_invalidation(ca)) {
+            co_sleep(1000);
+            continue;
+        }
+
+        redisReply* reply = read_reply(ca->c, ca->ev, -1);
+        if (reply != nullptr) {
+            handle_invalidation(ca, reply);
+            freeReplyObject(reply);
+            continue;
+        }
+
+        LOG_ERROR("redis invalidation conn error! node: %s, err: %d, errstr: %s",
+                  ca->ri->node.c_str(), ca->c->err, ca->c->errstr);
+
+        /* invalidations may be lost, drop the cache. */
+        ca->client_id = 0;
+        ca->cache->clear();
+        co_fd_event_free(ca->ev);
+        ca->ev = nullptr;
+        redisFree(ca->c);
+        ca->c = nullptr;
+        co_sleep(1000);
+    }
+}
+
+bool RedisMgr::cache_stats(const std::string& node, RedisCache::stats_t& stats) {
+    auto it = m_caches.find(node);
+    if (it == m_caches.end()) {
+        return false;
+    }
+    stats = it->second->cache->stats();
+    return true;
+}
+
 bool RedisMgr::init(CJsonObject* config) {
     if (config == nullptr) {
         LOG_ERROR("invalid params!");
@@ -233,30 +954,92 @@ bool RedisMgr::init(CJsonObject* config) {
             return false;
         }
 
+        ri->reply_timeout = IO_TIME_OUT;
+        json_obj.Get("reply_timeout", ri->reply_timeout);
+        if (ri->reply_timeout <= 0) {
+            ri->reply_timeout = IO_TIME_OUT;
+        }
+
+        json_obj.Get("cluster", ri->is_cluster);
+        if (ri->is_cluster) {
+            auto cl = std::make_shared<cluster_data_t>();
+            cl->ri = ri;
+            cl->slots = std::make_shared<RedisCluster>(ri->host, ri->port);
+            cl->cond = co_cond_alloc();
+            m_clusters[node] = cl;
+        }
+
+        CJsonObject cache_obj;
+        bool is_cache = false;
+        if (json_obj.Get("cache", cache_obj) && cache_obj.Get("is_open", is_cache) && is_cache) {
+            if (ri->is_cluster) {
+                LOG_WARN("redis cluster does not support client side cache! node: %s", node.c_str());
+            } else {
+                int max_memory = CACHE_MAX_MEMORY;
+                cache_obj.Get("max_memory", max_memory);
+                if (max_memory <= 0) {
+                    max_memory = CACHE_MAX_MEMORY;
+                }
+                auto ca = std::make_shared<cache_data_t>();
+                ca->ri = ri;
+                ca->cache = std::make_shared<RedisCache>((size_t)max_memory * 1024 * 1024);
+                m_caches[node] = ca;
+                LOG_INFO("redis client side cache is open! node: %s, max memory: %dMB",
+                         node.c_str(), max_memory);
+            }
+        }
+
         m_rds_infos[node] = ri;
-        LOG_INFO("init node info, node: %s, host: %s, port: %d, max_conn_cnt: %d",
-                 ri->node.c_str(), ri->host.c_str(), ri->port, ri->max_conn_cnt);
+        LOG_INFO("init node info, node: %s, host: %s, port: %d, max_conn_cnt: %d, cluster: %d, reply_timeout: %d",
+                 ri->node.c_str(), ri->host.c_str(), ri->port, ri->max_conn_cnt, ri->is_cluster,
+                 ri->reply_timeout);
     }
 
     return true;
 }
 
-redisContext* RedisMgr::connect(const std::string& host, int port) {
+bool RedisMgr::connect(std::shared_ptr<co_data_t> cd) {
+    cd->c = connect(cd->ri->host, cd->ri->port, &cd->ev);
+    return (cd->c != nullptr);
+}
+
+redisContext* RedisMgr::connect(const std::string& host, int port, stCoFdEvent_t** ev) {
     if (host.empty() || port == 0) {
         LOG_ERROR("invalid params!");
         return nullptr;
     }
 
-    redisContext* c = redisConnect(host.c_str(), port);
+    /* non-blocking conn, the writer and the reader wait on its fd event. */
+    redisContext* c = redisConnectNonBlock(host.c_str(), port);
     if (c == nullptr || c->err) {
         if (c != nullptr) {
             LOG_ERROR("redis conn error: %s", c->errstr);
             redisFree(c);
+            return nullptr;
         }
         LOG_ERROR("redis conn error: can't allocate redis context.");
         return nullptr;
     }
 
+    *ev = co_fd_event_alloc(c->fd);
+    if (*ev == nullptr) {
+        LOG_ERROR("redis conn error: alloc fd event failed! fd: %d, errno: %d", c->fd, errno);
+        redisFree(c);
+        return nullptr;
+    }
+
+    int err = 0;
+    socklen_t len = sizeof(err);
+    if (co_fd_event_wait(*ev, POLLOUT, IO_TIME_OUT) <= 0 ||
+        getsockopt(c->fd, SOL_SOCKET, SO_ERROR, &err, &len) < 0 || err != 0) {
+        LOG_ERROR("redis conn error: connect failed! host: %s, port: %d, err: %d",
+                  host.c_str(), port, err);
+        co_fd_event_free(*ev);
+        *ev = nullptr;
+        redisFree(c);
+        return nullptr;
+    }
+
     LOG_INFO("redis connect done! conn: %p, host: %s, port: %d", c, host.c_str(), port);
     return c;
 }
@@ -265,12 +1048,33 @@ void RedisMgr::destroy() {
     for (auto it : m_coroutines) {
         auto ad = it.second;
         for (auto& cd : ad->coroutines) {
+            co_fd_event_free(cd->ev);
             redisFree(cd->c);
             co_release(cd->co);
+            co_release(cd->reader_co);
             co_cond_free(cd->cond);
+            co_cond_free(cd->reader_cond);
         }
     }
     m_coroutines.clear();
+
+    for (auto it : m_clusters) {
+        if (it.second->co != nullptr) {
+            co_release(it.second->co);
+        }
+        co_cond_free(it.second->cond);
+    }
+    m_clusters.clear();
+
+    for (auto it : m_caches) {
+        auto ca = it.second;
+        co_fd_event_free(ca->ev);
+        redisFree(ca->c);
+        if (ca->co != nullptr) {
+            co_release(ca->co);
+        }
+    }
+    m_caches.clear();
 }
 
 }  // namespace kim
@@ -1,12 +1,41 @@
 #pragma once
 
+#include <type_traits>
+
 #include "../error.h"
 #include "../libco/co_routine.h"
 #include "../libco/co_routine_inner.h"
 #include "../server.h"
+#include "redis_cache.h"
+#include "redis_cluster.h"
 
 namespace kim {
 
+/* binary-safe argument of a redis cmd, it refers to the caller's
+ * data without copying, integers are converted into its own buffer. */
+class RedisArg {
+   public:
+    RedisArg(const char* s) : m_data(s), m_len(strlen(s)) {}
+    RedisArg(const char* data, size_t len) : m_data(data), m_len(len) {}
+    RedisArg(const std::string& s) : m_data(s.data()), m_len(s.size()) {}
+
+    template <typename T, typename = typename std::enable_if<
+                              std::is_integral<T>::value && !std::is_same<T, bool>::value>::type>
+    RedisArg(T v) {
+        m_len = std::is_signed<T>::value
+                    ? snprintf(m_buf, sizeof(m_buf), "%lld", (long long)v)
+                    : snprintf(m_buf, sizeof(m_buf), "%llu", (unsigned long long)v);
+    }
+
+    const char* data() const { return (m_data != nullptr) ? m_data : m_buf; }
+    size_t size() const { return m_len; }
+
+   private:
+    const char* m_data = nullptr;
+    size_t m_len = 0;
+    char m_buf[24];
+};
+
 class RedisMgr : Logger {
     /* redis info. */
     typedef struct redis_info_s {
@@ -14,32 +43,88 @@ class RedisMgr : Logger {
         std::string host;
         std::string node;
         int max_conn_cnt = 0;
+        bool is_cluster = false; /* the node is a seed of redis cluster. */
+        int reply_timeout = 0;   /* ms, the conn is broken if no reply arrives for so long. */
     } redis_info_t;
 
+    /* tasks sent together, the caller is resumed when all of them are done. */
+    typedef struct batch_s {
+        int pending = 0;
+        stCoRoutine_t* co = nullptr;
+    } batch_t;
+
     /* redis cmd task. */
     typedef struct task_s {
         int ret = ERR_OK;
-        std::string cmd;             /* redis cmd. */
-        stCoRoutine_t* co = nullptr; /* user's coroutine. */
+        char* cmd = nullptr;         /* redis cmd, encoded in RESP by the caller. */
+        int cmd_len = 0;             /* cmd's length. */
+        stCoRoutine_t* co = nullptr; /* user's coroutine, nullptr: nobody waits for the reply. */
         redisReply* reply = nullptr; /* redis cmd's reply. */
+        bool is_cluster = false;     /* keep MOVED/ASK error replies for redirection. */
+        std::string host;            /* host of the node which replied MOVED/ASK. */
+        std::shared_ptr<batch_t> batch = nullptr;
+        bool is_tracking = false;    /* CLIENT TRACKING cmd of the conn. */
+        long long tracking_id = 0;   /* invalidation conn's client id, the reply is tracked with. */
+        int block_time = 0;          /* ms, blocking cmd (BLPOP...) waits on server, -1: forever. */
+        ~task_s() { redisFreeCommand(cmd); }
     } task_t;
 
-    /* coroutines arg. */
+    /* identical reads in flight share one request, the followers
+     * get copies of the leader's reply. */
+    typedef struct flight_s {
+        int ret = ERR_OK;
+        uint64_t write_seq = 0;                /* node's writes done when the read was sent. */
+        redisReply* reply = nullptr;           /* leader's reply, owned by the leader. */
+        std::vector<stCoRoutine_t*> followers; /* coroutines wait for the reply. */
+    } flight_t;
+
+    /* client side cache, the invalidation conn subscribes
+     * __redis__:invalidate, data conns redirect their tracking to it. */
+    typedef struct cache_data_s {
+        std::shared_ptr<redis_info_t> ri = nullptr;
+        std::shared_ptr<RedisCache> cache = nullptr;
+        stCoRoutine_t* co = nullptr; /* invalidation conn's coroutine. */
+        redisContext* c = nullptr;   /* invalidation conn (non-blocking). */
+        stCoFdEvent_t* ev = nullptr; /* invalidation conn's fd event. */
+        long long client_id = 0;     /* invalidation conn's client id, 0: not ready. */
+    } cache_data_t;
+
+    /* coroutines arg. the writer coroutine streams tasks' cmds to redis,
+     * the reader coroutine resumes the tasks one by one as replies arrive. */
     typedef struct co_data_s {
-        stCoRoutine_t* co = nullptr;                /* redis conn's coroutine. */
-        stCoCond_t* cond = nullptr;                 /* coroutine cond. */
-        redisContext* c = nullptr;                  /* redis conn. */
-        std::shared_ptr<redis_info_t> ri = nullptr; /* redis info(host,port...) */
-        std::queue<std::shared_ptr<task_t>> tasks;  /* tasks wait to be handled. */
-        void* privdata = nullptr;                   /* user's data. */
+        stCoRoutine_t* co = nullptr;                  /* writer coroutine. */
+        stCoRoutine_t* reader_co = nullptr;           /* reader coroutine. */
+        stCoCond_t* cond = nullptr;                   /* writer's cond. */
+        stCoCond_t* reader_cond = nullptr;            /* reader's cond. */
+        redisContext* c = nullptr;                    /* redis conn (non-blocking). */
+        stCoFdEvent_t* ev = nullptr;                  /* conn's fd event. */
+        bool is_broken = false;                       /* conn error, writer will close it. */
+        std::shared_ptr<redis_info_t> ri = nullptr;   /* redis info(host,port...) */
+        std::queue<std::shared_ptr<task_t>> tasks;    /* tasks wait to be sent. */
+        std::queue<std::shared_ptr<task_t>> waiting;  /* tasks sent, wait for replies. */
+        void* privdata = nullptr;                     /* user's data. */
+        std::shared_ptr<cache_data_t> ca = nullptr;   /* client side cache. */
+        long long tracking_sent = 0;                  /* CLIENT TRACKING REDIRECT id sent. */
+        long long tracking_id = 0;                    /* CLIENT TRACKING REDIRECT id confirmed. */
+        uint64_t reply_time = 0;                      /* last reply arrived, or the first cmd sent after idle. */
     } co_data_t;
 
     typedef struct co_array_data_s {
-        int cur_idx = 0;
         std::shared_ptr<redis_info_t> ri = nullptr; /* redis info(host,port...) */
         std::vector<std::shared_ptr<co_data_t>> coroutines;
     } co_array_data_t;
 
+    /* redis cluster, every master has its own conn pool,
+     * which is named "node@host:port". */
+    typedef struct cluster_data_s {
+        std::shared_ptr<redis_info_t> ri = nullptr; /* seed's info. */
+        std::shared_ptr<RedisCluster> slots;         /* slot -> master. */
+        stCoRoutine_t* co = nullptr;                 /* coroutine which refreshes the slots. */
+        stCoCond_t* cond = nullptr;
+        bool need_refresh = true;
+        uint64_t refresh_time = 0;
+    } cluster_data_t;
+
    public:
     RedisMgr(std::shared_ptr<Log> log);
     virtual ~RedisMgr();
@@ -48,6 +133,12 @@ class RedisMgr : Logger {
     /**
      * ./bin/config json:
      * {"redis":{"test":{"host":"127.0.0.1","port":6379,"max_conn_cnt":1}}}
+     * redis cluster, host and port are one of the masters:
+     * {"redis":{"test":{"host":"127.0.0.1","port":7000,"max_conn_cnt":1,"cluster":true}}}
+     * client side cache (redis >= 6.0), max_memory: MB:
+     * {"redis":{"test":{...,"cache":{"is_open":true,"max_memory":64}}}}
+     * reply_timeout (ms, default 3000): the conn is closed if no reply arrives
+     * for so long while cmds are in flight, blocking cmds (BLPOP...) add their own timeout.
      */
     bool init(CJsonObject* config);
 
@@ -59,25 +150,116 @@ class RedisMgr : Logger {
      * @param r: redisReply result.
      *
      * @return error.h / enum E_ERROR.
+     *
+     * if the node's cache is open, the replies of read cmds (GET/HGET/HGETALL...)
+     * are cached, the cached ones are returned without waiting for redis.
+     * concurrent identical read cmds share one request, every caller gets its own reply.
+     * a read never shares a request sent before a write cmd to the node is done,
+     * so a coroutine reads its own writes.
      */
     int exec_cmd(const std::string& node, const std::string& cmd, redisReply** r);
 
+    /**
+     * @brief binary-safe redis read/write interface, arguments are
+     * encoded in RESP directly, without parsing a format string.
+     *
+     * @param node: define in config.json {"redis":{"node":{...}}}
+     * @param argc: arguments' count.
+     * @param argv: arguments, "set", key, value...
+     * @param argvlen: arguments' length.
+     * @param r: redisReply result.
+     *
+     * @return error.h / enum E_ERROR.
+     */
+    int exec_cmd_argv(const std::string& node, int argc,
+                      const char** argv, const size_t* argvlen, redisReply** r);
+
+    /**
+     * @brief variadic helper of exec_cmd_argv, arguments can be
+     * const char* / std::string / RedisArg(data, len) / integers.
+     * ex: exec_cmd_args("test", &reply, "set", key, RedisArg(data, len));
+     */
+    template <typename... Args>
+    int exec_cmd_args(const std::string& node, redisReply** r, const Args&... args) {
+        const RedisArg list[] = {RedisArg(args)...};
+        const char* argv[sizeof...(Args)];
+        size_t argvlen[sizeof...(Args)];
+        for (size_t i = 0; i < sizeof...(Args); i++) {
+            argv[i] = list[i].data();
+            argvlen[i] = list[i].size();
+        }
+        return exec_cmd_argv(node, (int)sizeof...(Args), argv, argvlen, r);
+    }
+
+    /**
+     * @brief pipelines cmds, in a cluster, they are split by slots' masters.
+     *
+     * @param node: define in config.json {"redis":{"node":{...}}}
+     * @param cmds: cmds' arguments.
+     * @param replies: replies in the order of cmds, nullptr: the cmd failed.
+     *
+     * @return error.h / enum E_ERROR, ERR_OK: all cmds are done.
+     */
+    int exec_cmds(const std::string& node, const std::vector<std::vector<RedisArg>>& cmds,
+                  std::vector<redisReply*>& replies);
+
+    /* client side cache's stats, false: the node has no cache. */
+    bool cache_stats(const std::string& node, RedisCache::stats_t& stats);
+
    private:
     void destroy();
     std::shared_ptr<co_data_t> get_co_data(const std::string& node);
-    redisContext* connect(const std::string& host, int port);
+    bool connect(std::shared_ptr<co_data_t> cd);
+    redisContext* connect(const std::string& host, int port, stCoFdEvent_t** ev);
+    void close_conn(std::shared_ptr<co_data_t> cd);
+    void set_conn_error(std::shared_ptr<co_data_t> cd, const char* reason);
 
     void on_handle_task(std::shared_ptr<co_data_t> cd);
-    int send_task(const std::string& node, const std::string& cmd, redisReply** r);
+    void on_handle_reply(std::shared_ptr<co_data_t> cd);
+    int send_task(const std::string& node, std::shared_ptr<task_t> task, redisReply** r);
+    int send_read_task(const std::string& node, std::shared_ptr<task_t> task, redisReply** r);
+    int push_task(const std::string& node, std::shared_ptr<task_t> task, bool is_asking = false);
+    void resume_task(std::shared_ptr<task_t> task);
     void clear_co_tasks(std::shared_ptr<co_data_t> cd);
+    std::shared_ptr<task_t> format_task(int argc, const char** argv, const size_t* argvlen);
+
+    /* redis cluster. */
+    int send_cluster_task(std::shared_ptr<cluster_data_t> cl, std::shared_ptr<task_t> task, redisReply** r);
+    int redirect_cluster_task(std::shared_ptr<cluster_data_t> cl, std::shared_ptr<task_t> task);
+    std::string cluster_pool(std::shared_ptr<cluster_data_t> cl, const RedisCluster::addr_t& addr);
+    int cluster_task_slot(std::shared_ptr<task_t> task);
+    void refresh_cluster(std::shared_ptr<cluster_data_t> cl);
+    void load_cluster_slots(std::shared_ptr<cluster_data_t> cl);
+    void on_refresh_cluster(std::shared_ptr<cluster_data_t> cl);
+
+    /* client side cache. */
+    int send_cached_task(std::shared_ptr<cache_data_t> ca, const std::string& node,
+                         const std::string& key, std::shared_ptr<task_t> task, redisReply** r);
+    bool append_tracking_cmd(std::shared_ptr<co_data_t> cd);
+    bool connect_invalidation(std::shared_ptr<cache_data_t> ca);
+    redisReply* read_reply(redisContext* c, stCoFdEvent_t* ev, int timeout);
+    void handle_invalidation(std::shared_ptr<cache_data_t> ca, redisReply* reply);
+    void on_invalidation(std::shared_ptr<cache_data_t> ca);
 
-    void handle_redis_cmd(std::shared_ptr<co_data_t> cd);
+    bool append_redis_cmds(std::shared_ptr<co_data_t> cd);
+    bool flush_redis_cmds(std::shared_ptr<co_data_t> cd);
+    void handle_redis_reply(std::shared_ptr<co_data_t> cd, redisReply* reply);
+    /* ms left to wait for the next reply, -1: a cmd blocks without timeout. */
+    int reply_timeout(std::shared_ptr<co_data_t> cd);
 
    private:
     /* key: node, valude: config data. */
     std::unordered_map<std::string, std::shared_ptr<redis_info_t>> m_rds_infos;
     /* key: node, value: conn array data. */
     std::unordered_map<std::string, std::shared_ptr<co_array_data_t>> m_coroutines;
+    /* key: cluster's node, value: cluster data. */
+    std::unordered_map<std::string, std::shared_ptr<cluster_data_t>> m_clusters;
+    /* key: node, value: client side cache data. */
+    std::unordered_map<std::string, std::shared_ptr<cache_data_t>> m_caches;
+    /* key: node + '\0' + cmd, value: read in flight. */
+    std::unordered_map<std::string, std::shared_ptr<flight_t>> m_flights;
+    /* key: node, value: count of write cmds done, the reads in flight before are not shared. */
+    std::unordered_map<std::string, uint64_t> m_write_seqs;
 };
 
 }  // namespace kim
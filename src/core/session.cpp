@@ -13,15 +13,12 @@ Session::Session(std::shared_ptr<Log> logger, std::shared_ptr<INet> net, const s
 // SessionMgr
 ////////////////////////////////////////////////
 
-SessionMgr::SessionMgr(std::shared_ptr<Log> logger, std::shared_ptr<INet> net) : Logger(logger), Net(net) {
+SessionMgr::SessionMgr(std::shared_ptr<Log> logger, std::shared_ptr<INet> net)
+    : Logger(logger), Net(net), m_wheel(co_tick_ms()) {
 }
 
 bool SessionMgr::init() {
-    m_timers = std::make_shared<Timers>(logger());
-    if (!m_timers->init_timer()) {
-        return false;
-    }
-    return true;
+    return init_timer();
 }
 
 bool SessionMgr::add_session(std::shared_ptr<Session> session, uint64_t after, uint64_t repeat) {
@@ -42,12 +39,13 @@ bool SessionMgr::add_session(std::shared_ptr<Session> session, uint64_t after, u
         return false;
     }
 
-    auto timer = add_timer(session, after, repeat);
-    if (timer == nullptr) {
-        return false;
-    }
+    std::unique_ptr<tm_session_t> timer(new tm_session_t);
+    timer->after = after;
+    timer->repeat = repeat;
+    timer->session = session;
+    m_wheel.add(timer.get(), co_tick_ms() + after);
 
-    m_sessions[session->id()] = timer;
+    m_sessions[session->id()] = std::move(timer);
     LOG_DEBUG("add session done, sessid: %s, after: %llu, repeat: %llu",
               session->id(), after, repeat);
     return true;
@@ -61,43 +59,53 @@ std::shared_ptr<Session> SessionMgr::get_session(const std::string& id) {
     return nullptr;
 }
 
+bool SessionMgr::touch_session(const std::string& id) {
+    auto it = m_sessions.find(id);
+    if (it == m_sessions.end()) {
+        return false;
+    }
+    m_wheel.mod(it->second.get(), co_tick_ms() + it->second->after);
+    return true;
+}
+
 bool SessionMgr::del_session(const std::string& id) {
     auto it = m_sessions.find(id);
     if (it == m_sessions.end()) {
         return false;
     }
-    del_timer(it->second->timer_id);
+    /* node leaves the wheel when it is destroyed. */
     m_sessions.erase(it);
     LOG_DEBUG("delete session done! sessid: %s", id.c_str());
     return true;
 }
 
-std::shared_ptr<SessionMgr::tm_session_t>
-SessionMgr::add_timer(std::shared_ptr<Session> session, uint64_t after, uint64_t repeat) {
-    auto self = std::weak_ptr<SessionMgr>(shared_from_this());
-    auto timer = std::make_shared<tm_session_t>();
-    timer->session = session;
-
-    auto timer_id = m_timers->add_timer(
-        [this, timer, self](int timer_id, bool is_repeat, void* privdata) {
-            timer->session->on_timeout();
-            if (!is_repeat) {
-                auto p = self.lock();
-                if (p == nullptr) {
-                    return;
-                }
-                LOG_DEBUG("hit timeout callback, timer_id: %d", timer_id);
-                del_session(timer->session->id());
-            }
-        },
-        after, repeat);
-    timer->timer_id = timer_id;
-    return timer;
-}
-
-bool SessionMgr::del_timer(int id) {
-    LOG_DEBUG("delete timer, timer id: %d", id);
-    return m_timers->del_timer(id);
+void SessionMgr::on_repeat_timer() {
+    uint64_t now = co_tick_ms();
+    TimerNode* node;
+
+    while ((node = m_wheel.pop_expired(now)) != nullptr) {
+        tm_session_t* timer = static_cast<tm_session_t*>(node);
+        /* the session may be deleted in its callback. */
+        auto session = timer->session;
+        session->on_timeout();
+
+        auto it = m_sessions.find(session->id());
+        if (it == m_sessions.end() || it->second.get() != timer) {
+            continue;
+        }
+
+        if (timer->is_pending()) {
+            /* touched in callback. */
+            continue;
+        }
+
+        if (timer->repeat != 0) {
+            m_wheel.add(timer, now + timer->repeat);
+        } else {
+            LOG_DEBUG("hit session timeout, sessid: %s", session->id());
+            m_sessions.erase(it);
+        }
+    }
 }
 
 }  // namespace kim
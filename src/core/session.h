@@ -33,10 +33,11 @@ class Session : public Logger, public Net {
 // SessionMgr
 ////////////////////////////////////////////////
 
-class SessionMgr : public Logger, public Net, public std::enable_shared_from_this<SessionMgr> {
+class SessionMgr : public Logger, public Net, public CoTimer, public std::enable_shared_from_this<SessionMgr> {
    public:
-    typedef struct tm_session_s {
-        int timer_id = -1;
+    typedef struct tm_session_s : public TimerNode {
+        uint64_t after = 0;  /* timeout, restarts when the session is touched. */
+        uint64_t repeat = 0; /* repeat milliseconds. */
         std::shared_ptr<Session> session = nullptr;
     } tm_session_t;
 
@@ -47,6 +48,8 @@ class SessionMgr : public Logger, public Net, public std::enable_shared_from_thi
     bool del_session(const std::string& id);
     std::shared_ptr<Session> get_session(const std::string& id);
     bool add_session(std::shared_ptr<Session> session, uint64_t after, uint64_t repeat = 0);
+    /* session is active, reschedules its timeout to `after` milliseconds later. */
+    bool touch_session(const std::string& id);
 
     /* add an new obj, if find by session id failed. */
     template <typename T>
@@ -62,14 +65,13 @@ class SessionMgr : public Logger, public Net, public std::enable_shared_from_thi
         return session;
     }
 
-   private:
-    bool del_timer(int id);
-    std::shared_ptr<tm_session_t> add_timer(
-        std::shared_ptr<Session> session, uint64_t after, uint64_t repeat);
+   public:
+    /* call by CoTimer's coroutine. */
+    virtual void on_repeat_timer() override;
 
    private:
-    std::shared_ptr<Timers> m_timers;
-    std::unordered_map<std::string, std::shared_ptr<tm_session_t>> m_sessions;
+    TimerWheel m_wheel; /* sessions' timeout. */
+    std::unordered_map<std::string, std::unique_ptr<tm_session_t>> m_sessions;
 };
 
 }  // namespace kim
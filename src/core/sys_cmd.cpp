@@ -39,10 +39,14 @@ int SysCmd::handle_msg(std::shared_ptr<Msg> req) {
     return (net()->is_manager()) ? handle_manager_msg(req) : handle_worker_msg(req);
 }
 
-int SysCmd::send_heart_beat(std::shared_ptr<Connection> c) {
+int SysCmd::send_heart_beat(std::shared_ptr<Connection> c, uint32_t seq) {
     LOG_TRACE("send CMD_REQ_HEART_BEAT, fd: %d", c->fd());
 
-    int ret = net()->send_req(c, CMD_REQ_HEART_BEAT, net()->new_seq(), "heartbeat");
+    if (seq == 0) {
+        seq = net()->new_seq();
+    }
+
+    int ret = net()->send_req(c, CMD_REQ_HEART_BEAT, seq, "heartbeat");
     if (ret != ERR_OK) {
         LOG_ERROR("send CMD_REQ_HEART_BEAT failed! fd: %d", c->fd());
         return ret;
@@ -157,22 +161,18 @@ int SysCmd::on_req_update_payload(std::shared_ptr<Msg> req) {
 
     int ret;
     kim::Payload pl;
-    worker_info_t* info;
 
     if (!pl.ParseFromString(req->body()->data())) {
         LOG_ERROR("parse CMD_REQ_UPDATE_PAYLOAD data failed! fd: %d", req->fd());
         return ERR_INVALID_PROTOBUF_PACKET;
     }
 
-    info = net()->worker_data_mgr()->get_worker_info_by_index(pl.worker_index());
-    if (info == nullptr) {
+    if (!net()->worker_data_mgr()->update_payload(pl)) {
         net()->send_ack(req, ERR_INVALID_WORKER_INDEX, "can not find worker index!");
         LOG_ERROR("can not find worker index: %d", pl.worker_index());
         return ERR_INVALID_WORKER_INDEX;
     }
 
-    info->payload = pl;
-
     ret = net()->send_ack(req, ERR_OK, "ok");
     if (ret != ERR_OK) {
         LOG_ERROR("send CMD_RSP_UPDATE_PAYLOAD failed! fd: %d", req->fd());
@@ -15,7 +15,7 @@ class SysCmd : public Logger, public Net, public TimerCron {
     SysCmd(std::shared_ptr<Log> logger, std::shared_ptr<INet> net);
     virtual ~SysCmd() {}
 
-    int send_heart_beat(std::shared_ptr<Connection> c);
+    int send_heart_beat(std::shared_ptr<Connection> c, uint32_t seq = 0);
     int send_connect_req_to_worker(std::shared_ptr<Connection> c);
 
     /* worker send data to manager. */
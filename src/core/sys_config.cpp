@@ -53,10 +53,82 @@ bool SysConfig::is_reuseport() {
     return ret;
 }
 
+bool SysConfig::is_reuseport_cbpf() {
+    bool ret = false;
+    m_config->Get("reuseport_cbpf", ret);
+    return ret;
+}
+
+bool SysConfig::is_log_async() {
+    bool ret = false;
+    m_config->Get("log_async", ret);
+    return ret;
+}
+
+bool SysConfig::is_edge_trigger() {
+    bool ret = false;
+    m_config->Get("is_edge_trigger", ret);
+    return ret;
+}
+
+bool SysConfig::is_gate_pass_through() {
+    bool ret = false;
+    m_config->Get("gate_pass_through", ret);
+    return ret;
+}
+
+bool SysConfig::is_node_pipeline() {
+    bool ret = false;
+    m_config->Get("node_pipeline", ret);
+    return ret;
+}
+
+bool SysConfig::is_write_cork() {
+    bool ret = false;
+    m_config->Get("is_write_cork", ret);
+    return ret;
+}
+
 bool SysConfig::is_open_zookeeper() {
     bool ret = false;
     m_config->Get("zookeeper").Get("is_open", ret);
     return ret;
 }
 
+bool SysConfig::is_cpu_affinity() {
+    bool ret = false;
+    m_config->Get("cpu_affinity").Get("is_open", ret);
+    return ret;
+}
+
+std::vector<int> SysConfig::worker_cpus() {
+    std::vector<int> cpus;
+    CJsonObject& arr = m_config->Get("cpu_affinity").Get("cpus");
+    for (int i = 0; i < arr.GetArraySize(); i++) {
+        int32 cpu = -1;
+        if (arr.Get(i, cpu)) {
+            cpus.push_back(cpu);
+        }
+    }
+    return cpus;
+}
+
+int SysConfig::worker_cpu(int worker_index) {
+    int32 cpu = -1;
+    if (!is_cpu_affinity() || worker_index <= 0 ||
+        !m_config->Get("cpu_affinity").Get("cpus").Get(worker_index - 1, cpu)) {
+        return -1;
+    }
+    return cpu;
+}
+
+int SysConfig::worker_numa_node(int worker_index) {
+    int32 node = -1;
+    if (!is_cpu_affinity() || worker_index <= 0 ||
+        !m_config->Get("cpu_affinity").Get("numa_nodes").Get(worker_index - 1, node)) {
+        return -1;
+    }
+    return node;
+}
+
 }  // namespace kim
\ No newline at end of file
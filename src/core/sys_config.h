@@ -41,8 +41,22 @@ class SysConfig {
     int max_clients() { return str_to_int((*m_config)("max_clients")); }
 
     bool is_reuseport();
+    bool is_reuseport_cbpf();
+    bool is_log_async();
+    bool is_edge_trigger();
+    bool is_gate_pass_through();
+    bool is_node_pipeline();
+    bool is_write_cork();
+    std::string io_engine() { return (*m_config)("io_engine"); } /* epoll / io_uring. */
+    std::string worker_balance() { return (*m_config)("worker_balance"); }
     bool is_open_zookeeper();
 
+    /* cpu affinity, worker index starts from 1, returns -1 if not set. */
+    bool is_cpu_affinity();
+    std::vector<int> worker_cpus();
+    int worker_cpu(int worker_index);
+    int worker_numa_node(int worker_index);
+
    protected:
     CJsonObject* m_config = nullptr;
     std::string m_work_path;
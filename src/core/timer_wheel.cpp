@@ -0,0 +1,170 @@
+#include "timer_wheel.h"
+
+namespace kim {
+
+// TimerNode
+////////////////////////////////////////////////
+
+TimerNode::~TimerNode() {
+    if (m_wheel != nullptr) {
+        m_wheel->del(this);
+    }
+}
+
+// TimerWheel
+////////////////////////////////////////////////
+
+TimerWheel::TimerWheel(uint64_t now) : m_now(now) {
+    for (int i = 0; i < LEVEL_CNT; i++) {
+        for (int j = 0; j < LEVEL_SLOTS; j++) {
+            m_slots[i][j].m_prev = m_slots[i][j].m_next = &m_slots[i][j];
+        }
+    }
+    m_expired.m_prev = m_expired.m_next = &m_expired;
+}
+
+TimerWheel::~TimerWheel() {
+    /* detach the pending nodes, they may live longer than the wheel. */
+    auto detach = [](TimerNode* head) {
+        TimerNode* node = head->m_next;
+        while (node != head) {
+            TimerNode* next = node->m_next;
+            node->m_prev = node->m_next = nullptr;
+            node->m_wheel = nullptr;
+            node = next;
+        }
+        head->m_prev = head->m_next = nullptr;
+    };
+
+    for (int i = 0; i < LEVEL_CNT; i++) {
+        for (int j = 0; j < LEVEL_SLOTS; j++) {
+            detach(&m_slots[i][j]);
+        }
+    }
+    detach(&m_expired);
+    m_size = 0;
+}
+
+void TimerWheel::append(TimerNode* head, TimerNode* node) {
+    node->m_prev = head->m_prev;
+    node->m_next = head;
+    head->m_prev->m_next = node;
+    head->m_prev = node;
+}
+
+void TimerWheel::add(TimerNode* node, uint64_t expire) {
+    if (node->m_wheel != nullptr) {
+        node->m_wheel->del(node);
+    }
+
+    /* the current tick has been handled, so it will be due in next tick. */
+    node->m_expire = (expire > m_now) ? expire : m_now + 1;
+    node->m_wheel = this;
+    link(node);
+    m_size++;
+}
+
+void TimerWheel::del(TimerNode* node) {
+    if (node->m_wheel != this) {
+        return;
+    }
+    if (node->m_level >= 0) {
+        m_level_cnt[node->m_level]--;
+    }
+    node->unlink();
+    node->m_wheel = nullptr;
+    m_size--;
+}
+
+void TimerWheel::link(TimerNode* node) {
+    uint64_t expire = node->m_expire;
+    uint64_t delta = expire - m_now;
+    int level = 0;
+
+    /* the later timers wait in the last level's slot. */
+    if (delta >= ((uint64_t)1 << (LEVEL_BITS * LEVEL_CNT))) {
+        delta = ((uint64_t)1 << (LEVEL_BITS * LEVEL_CNT)) - 1;
+        expire = m_now + delta;
+    }
+
+    while (level < LEVEL_CNT - 1 && delta >= ((uint64_t)1 << (LEVEL_BITS * (level + 1)))) {
+        level++;
+    }
+
+    int slot = (expire >> (LEVEL_BITS * level)) & (LEVEL_SLOTS - 1);
+    append(&m_slots[level][slot], node);
+    node->m_level = level;
+    m_level_cnt[level]++;
+}
+
+void TimerWheel::cascade(int level) {
+    int slot = (m_now >> (LEVEL_BITS * level)) & (LEVEL_SLOTS - 1);
+    TimerNode* head = &m_slots[level][slot];
+
+    /* relink to lower levels, they are due in the next LEVEL_SLOTS^level ticks. */
+    TimerNode* node = head->m_next;
+    head->m_prev = head->m_next = head;
+    while (node != head) {
+        TimerNode* next = node->m_next;
+        m_level_cnt[level]--;
+        link(node);
+        node = next;
+    }
+}
+
+void TimerWheel::turn(uint64_t now) {
+    if (m_size == 0) {
+        m_now = (now > m_now) ? now : m_now;
+        return;
+    }
+
+    while (m_now < now) {
+        /* skip the empty levels, turn to the next slot which has to be cascaded. */
+        for (int level = 0; level < LEVEL_CNT && m_level_cnt[level] == 0; level++) {
+            uint64_t mask = ((uint64_t)1 << (LEVEL_BITS * (level + 1))) - 1;
+            uint64_t next = (m_now | mask) + 1;
+            if (next > now) {
+                m_now = now;
+                return;
+            }
+            m_now = next - 1;
+        }
+
+        m_now++;
+
+        int slot = m_now & (LEVEL_SLOTS - 1);
+        for (int level = 1; level < LEVEL_CNT && slot == 0; level++) {
+            cascade(level);
+            slot = (m_now >> (LEVEL_BITS * level)) & (LEVEL_SLOTS - 1);
+        }
+
+        /* move the due slot into expired list. */
+        TimerNode* head = &m_slots[0][m_now & (LEVEL_SLOTS - 1)];
+        if (head->m_next != head) {
+            for (TimerNode* node = head->m_next; node != head; node = node->m_next) {
+                node->m_level = -1;
+                m_level_cnt[0]--;
+            }
+            head->m_next->m_prev = m_expired.m_prev;
+            m_expired.m_prev->m_next = head->m_next;
+            head->m_prev->m_next = &m_expired;
+            m_expired.m_prev = head->m_prev;
+            head->m_prev = head->m_next = head;
+        }
+    }
+}
+
+TimerNode* TimerWheel::pop_expired(uint64_t now) {
+    if (m_expired.m_next == &m_expired) {
+        turn(now);
+        if (m_expired.m_next == &m_expired) {
+            return nullptr;
+        }
+    }
+
+    TimerNode* node = m_expired.m_next;
+    del(node);
+    return node;
+}
+
+}  // namespace kim
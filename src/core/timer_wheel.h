@@ -0,0 +1,84 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace kim {
+
+class TimerWheel;
+
+/* intrusive node, embedded in the object which needs a timer. */
+class TimerNode {
+   public:
+    TimerNode() = default;
+    virtual ~TimerNode();
+
+    TimerNode(const TimerNode&) = delete;
+    TimerNode& operator=(const TimerNode&) = delete;
+
+    bool is_pending() const { return m_next != nullptr; }
+    uint64_t expire_time() const { return m_expire; }
+
+   private:
+    friend class TimerWheel;
+
+    void unlink() {
+        m_prev->m_next = m_next;
+        m_next->m_prev = m_prev;
+        m_prev = m_next = nullptr;
+    }
+
+   private:
+    TimerNode* m_prev = nullptr;
+    TimerNode* m_next = nullptr;
+    TimerWheel* m_wheel = nullptr; /* the wheel which the node is pending in. */
+    int m_level = -1;              /* wheel's level, -1: expired list. */
+    uint64_t m_expire = 0;         /* due time in milliseconds. */
+};
+
+/**
+ * hierarchical timing wheel, milliseconds per tick.
+ * 4 levels * 256 slots, covers 2^32 ms (~49 days), the later timers
+ * wait in the last level and are cascaded again.
+ * add/del/mod are O(1), the nodes in a higher level slot are cascaded
+ * into the lower level when the wheel turns to it.
+ */
+class TimerWheel {
+   public:
+    static const int LEVEL_BITS = 8;
+    static const int LEVEL_SLOTS = 1 << LEVEL_BITS;
+    static const int LEVEL_CNT = 4;
+
+    TimerWheel(uint64_t now);
+    virtual ~TimerWheel();
+
+    TimerWheel(const TimerWheel&) = delete;
+    TimerWheel& operator=(const TimerWheel&) = delete;
+
+    /* expire: due time in milliseconds, the node will be relinked if it is pending. */
+    void add(TimerNode* node, uint64_t expire);
+    void del(TimerNode* node);
+    void mod(TimerNode* node, uint64_t expire) { add(node, expire); }
+
+    /* turns the wheel to now, returns an expired node, nullptr if there is none.
+     * the node has been removed from the wheel before it is returned. */
+    TimerNode* pop_expired(uint64_t now);
+
+    size_t size() const { return m_size; }
+    uint64_t now() const { return m_now; }
+
+   private:
+    void link(TimerNode* node);
+    void cascade(int level);
+    void turn(uint64_t now);
+    static void append(TimerNode* head, TimerNode* node);
+
+   private:
+    uint64_t m_now = 0;                         /* current tick. */
+    size_t m_size = 0;                          /* pending nodes. */
+    size_t m_level_cnt[LEVEL_CNT] = {0};        /* nodes in levels, empty levels are skipped. */
+    TimerNode m_slots[LEVEL_CNT][LEVEL_SLOTS];  /* slot list's head. */
+    TimerNode m_expired;                        /* expired list's head. */
+};
+
+}  // namespace kim
@@ -12,14 +12,42 @@ Timer::Timer(int id, const TimerCallback& fn, uint64_t after, uint64_t repeat, v
 // Timers
 ////////////////////////////////////////////////
 
+Timers::~Timers() {
+    for (auto& it : m_ids) {
+        delete it.second;
+    }
+    for (auto timer : m_free_timers) {
+        delete timer;
+    }
+}
+
+Timer* Timers::alloc_timer() {
+    if (m_free_timers.empty()) {
+        return new Timer;
+    }
+    Timer* timer = m_free_timers.back();
+    m_free_timers.pop_back();
+    return timer;
+}
+
+void Timers::recycle_timer(Timer* timer) {
+    timer->set_callback(nullptr);
+    timer->set_privdata(nullptr);
+    m_free_timers.push_back(timer);
+}
+
 int Timers::add_timer(const TimerCallback& fn,
                       uint64_t after, uint64_t repeat, void* privdata) {
     int id = new_tid();
-    TimerGrpID gid = {mstime() + after, id};
-    auto timer = std::make_shared<Timer>(id, fn, after, repeat, privdata);
+    Timer* timer = alloc_timer();
+    timer->set_id(id);
+    timer->set_callback(fn);
+    timer->set_after_time(after);
+    timer->set_repeat_time(repeat);
+    timer->set_privdata(privdata);
 
-    m_timers[gid] = timer;
-    m_ids[id] = gid;
+    m_wheel.add(timer, co_tick_ms() + after);
+    m_ids[id] = timer;
 
     LOG_DEBUG("add timer done! id: %d", id);
     return id;
@@ -31,50 +59,57 @@ bool Timers::del_timer(int id) {
         return false;
     }
 
-    auto it_timer = m_timers.find(it->second);
-    if (it_timer != m_timers.end()) {
-        m_timers.erase(it_timer);
-    }
+    Timer* timer = it->second;
     m_ids.erase(it);
+    m_wheel.del(timer);
+
+    if (timer == m_firing) {
+        /* deleted in its own callback, recycle it after the callback. */
+        m_firing = nullptr;
+    } else {
+        recycle_timer(timer);
+    }
 
     LOG_DEBUG("delete timer done! id: %d", id);
     return true;
 }
 
 void Timers::on_repeat_timer() {
-    uint64_t now = mstime();
+    uint64_t now = co_tick_ms();
+    TimerNode* node;
 
-    while (!m_timers.empty() && (m_timers.begin()->first.first < now)) {
-        auto it = m_timers.begin();
-        auto gid = it->first;
-        auto timer = it->second;
-        auto callback = timer->callback();
+    while ((node = m_wheel.pop_expired(now)) != nullptr) {
+        Timer* timer = static_cast<Timer*>(node);
+        int id = timer->id();
+        bool is_repeat = (timer->repeat_time() != 0);
 
-        m_timers.erase(it);
+        m_firing = timer;
+        if (timer->callback() != nullptr) {
+            timer->callback()(id, is_repeat, timer->privdata());
+        }
 
-        if (callback != nullptr) {
-            callback(timer->id(), timer->repeat_time() != 0, timer->privdata());
+        if (m_firing == nullptr) {
+            LOG_TRACE("timer has been deleted in callback, id: %d", id);
+            recycle_timer(timer);
+            continue;
         }
+        m_firing = nullptr;
 
-        if (timer->repeat_time() != 0) {
+        if (is_repeat) {
             LOG_TRACE("repeat timer hit, timer id: %d, timeout: %llu, now: %llu",
-                      gid.second, gid.first, now);
-            TimerGrpID new_gid = {mstime() + timer->repeat_time(), gid.second};
-            m_timers[new_gid] = timer;
-            m_ids[gid.second] = new_gid;
+                      id, timer->expire_time(), now);
+            m_wheel.add(timer, now + timer->repeat_time());
         } else {
-            LOG_TRACE("no repeat timer hit, delete timer, id: %d", gid.second);
-            auto itr = m_ids.find(gid.first);
-            if (itr != m_ids.end()) {
-                m_ids.erase(itr);
-            }
+            LOG_TRACE("no repeat timer hit, delete timer, id: %d", id);
+            m_ids.erase(id);
+            recycle_timer(timer);
         }
     }
 
     run_with_period(1000) {
-        if (!m_timers.empty() || !m_ids.empty()) {
+        if (!m_ids.empty()) {
             LOG_TRACE("timers's cnt: %lu, timer ids's cnt: %lu",
-                      m_timers.size(), m_ids.size());
+                      m_wheel.size(), m_ids.size());
         }
     }
 }
@@ -2,12 +2,10 @@
 
 #include "server.h"
 #include "timer.h"
+#include "timer_wheel.h"
 
 namespace kim {
 
-/* timer's group id (first: due time, second: timer id)*/
-using TimerGrpID = std::pair<uint64_t, int>;
-
 /* timer's callback function.
  * first arg: timer's id.
  * second arg: is repeat.
@@ -18,7 +16,7 @@ using TimerCallback = std::function<void(int, bool, void*)>;
 // Timer
 ////////////////////////////////////////////////
 
-class Timer {
+class Timer : public TimerNode {
    public:
     Timer() {}
     Timer(int id, const TimerCallback& fn, uint64_t after, uint64_t repeat, void* privdata);
@@ -52,8 +50,8 @@ class Timer {
 
 class Timers : public Logger, public CoTimer {
    public:
-    Timers(std::shared_ptr<Log> logger) : Logger(logger) {}
-    virtual ~Timers() {}
+    Timers(std::shared_ptr<Log> logger) : Logger(logger), m_wheel(co_tick_ms()) {}
+    virtual ~Timers();
 
     Timers(const Timers&) = delete;
     Timers& operator=(const Timers&) = delete;
@@ -68,11 +66,15 @@ class Timers : public Logger, public CoTimer {
 
    private:
     int new_tid() { return ++m_last_timer_id; }
+    Timer* alloc_timer();
+    void recycle_timer(Timer* timer);
 
    protected:
     int m_last_timer_id = 0;
-    std::map<TimerGrpID, std::shared_ptr<Timer>> m_timers;
-    std::unordered_map<int, TimerGrpID> m_ids; /* key: timer's id. */
+    TimerWheel m_wheel;                     /* pending timers. */
+    std::unordered_map<int, Timer*> m_ids;  /* key: timer's id. */
+    std::vector<Timer*> m_free_timers;      /* recycled timers. */
+    Timer* m_firing = nullptr;              /* timer whose callback is running. */
 };
 
 }  // namespace kim
@@ -0,0 +1,115 @@
+#include "buffer_pool.h"
+
+#include <stdio.h>
+
+namespace kim {
+
+BufferPool::~BufferPool() {
+    trim();
+}
+
+BufferPool* BufferPool::instance() {
+    /* not destroyed with the thread, buffers may be freed in
+     * static objects' destructors after thread_local's. */
+    static thread_local BufferPool* pool = nullptr;
+    if (pool == nullptr) {
+        pool = new BufferPool;
+    }
+    return pool;
+}
+
+int BufferPool::class_index(size_t size) {
+    if (size <= ((size_t)1 << MIN_CLASS_SHIFT)) {
+        return 0;
+    }
+    /* ceil(log2(size)). */
+    int shift = 64 - __builtin_clzll((unsigned long long)(size - 1));
+    if (shift > MAX_CLASS_SHIFT) {
+        return -1;
+    }
+    return shift - MIN_CLASS_SHIFT;
+}
+
+size_t BufferPool::block_size(size_t size) {
+    int index = class_index(size);
+    return (index < 0) ? size : ((size_t)1 << (index + MIN_CLASS_SHIFT));
+}
+
+size_t BufferPool::max_free_blocks(int index) {
+    size_t cnt = MAX_FREE_BYTES >> (index + MIN_CLASS_SHIFT);
+    if (cnt < MIN_FREE_BLOCKS) {
+        cnt = MIN_FREE_BLOCKS;
+    }
+    return cnt;
+}
+
+char* BufferPool::alloc(size_t size, size_t& block_len) {
+    int index = class_index(size);
+    if (index < 0) {
+        m_huge_cnt++;
+        m_miss_cnt++;
+        block_len = size;
+        return (char*)malloc(size);
+    }
+
+    block_len = (size_t)1 << (index + MIN_CLASS_SHIFT);
+
+    block_t* b = m_free_blocks[index];
+    if (b != nullptr) {
+        m_free_blocks[index] = b->next;
+        m_class_free_cnt[index]--;
+        m_free_cnt--;
+        m_free_bytes -= block_len;
+        m_hit_cnt++;
+        return (char*)b;
+    }
+
+    m_miss_cnt++;
+    return (char*)malloc(block_len);
+}
+
+void BufferPool::free(char* block, size_t block_len) {
+    if (block == nullptr) {
+        return;
+    }
+
+    int index = class_index(block_len);
+    if (index < 0 ||
+        block_len != ((size_t)1 << (index + MIN_CLASS_SHIFT)) ||
+        m_class_free_cnt[index] >= max_free_blocks(index)) {
+        ::free(block);
+        return;
+    }
+
+    block_t* b = (block_t*)block;
+    b->next = m_free_blocks[index];
+    m_free_blocks[index] = b;
+    m_class_free_cnt[index]++;
+    m_free_cnt++;
+    m_free_bytes += block_len;
+}
+
+void BufferPool::trim() {
+    for (int i = 0; i < CLASS_CNT; i++) {
+        block_t* b = m_free_blocks[i];
+        while (b != nullptr) {
+            block_t* next = b->next;
+            ::free(b);
+            b = next;
+        }
+        m_free_blocks[i] = nullptr;
+        m_class_free_cnt[i] = 0;
+    }
+    m_free_cnt = 0;
+    m_free_bytes = 0;
+}
+
+std::string BufferPool::stats() {
+    char buf[256];
+    snprintf(buf, sizeof(buf), "free: %lu, free bytes: %lu, hit: %llu, miss: %llu, huge: %llu",
+             m_free_cnt, m_free_bytes, (unsigned long long)m_hit_cnt,
+             (unsigned long long)m_miss_cnt, (unsigned long long)m_huge_cnt);
+    return std::string(buf);
+}
+
+}  // namespace kim
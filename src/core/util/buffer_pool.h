@@ -0,0 +1,72 @@
+#ifndef __BUFFER_POOL_H__
+#define __BUFFER_POOL_H__
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <string>
+
+/**
+ * memory blocks for socket buffers, sizes are rounded up to power-of-two
+ * classes, freed blocks are cached in free lists of their classes.
+ * one pool per thread, a worker's connections run in its main thread,
+ * so the buffers churn in the worker's own pool without locks.
+ */
+
+namespace kim {
+
+class BufferPool {
+   public:
+    static const int MIN_CLASS_SHIFT = 5;                   /* 32 bytes. */
+    static const int MAX_CLASS_SHIFT = 22;                  /* 4 MB, larger blocks go to malloc directly. */
+    static const int CLASS_CNT = MAX_CLASS_SHIFT - MIN_CLASS_SHIFT + 1;
+    static const size_t MAX_FREE_BYTES = 4 * 1024 * 1024;   /* cached bytes limit of a class. */
+    static const size_t MIN_FREE_BLOCKS = 4;                /* cached blocks of a class at least. */
+
+    BufferPool() = default;
+    virtual ~BufferPool();
+
+    BufferPool(const BufferPool&) = delete;
+    BufferPool& operator=(const BufferPool&) = delete;
+
+    /* current thread's pool. */
+    static BufferPool* instance();
+
+    /* block_len: the block's real length, which must be passed back to free. */
+    char* alloc(size_t size, size_t& block_len);
+    /* the block's real length which alloc(size) returns. */
+    static size_t block_size(size_t size);
+    void free(char* block, size_t block_len);
+    /* release all cached blocks, called in timer, cached blocks are not kept for long. */
+    void trim();
+
+    /* statistics. */
+    uint64_t hit_cnt() { return m_hit_cnt; }
+    uint64_t miss_cnt() { return m_miss_cnt; }
+    uint64_t huge_cnt() { return m_huge_cnt; }
+    size_t free_cnt() { return m_free_cnt; }
+    size_t free_bytes() { return m_free_bytes; }
+    std::string stats();
+
+   private:
+    struct block_t {
+        block_t* next;
+    };
+
+    static int class_index(size_t size);
+    size_t max_free_blocks(int index);
+
+   private:
+    block_t* m_free_blocks[CLASS_CNT] = {nullptr}; /* free lists of classes. */
+    size_t m_class_free_cnt[CLASS_CNT] = {0};      /* blocks in free lists. */
+
+    uint64_t m_hit_cnt = 0;  /* alloc from free lists. */
+    uint64_t m_miss_cnt = 0; /* alloc from malloc. */
+    uint64_t m_huge_cnt = 0; /* larger than the max class. */
+    size_t m_free_cnt = 0;
+    size_t m_free_bytes = 0;
+};
+
+}  // namespace kim
+
+#endif  //__BUFFER_POOL_H__
@@ -1,17 +1,82 @@
 #include "log.h"
 
+#include <fcntl.h>
+#include <signal.h>
 #include <strings.h>
 #include <sys/time.h>
+#include <sys/uio.h>
 #include <time.h>
 #include <unistd.h>
 
-#include "log.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
 
 namespace kim {
 
 #define LOG_MAX_LEN 1024
+#define LOG_LINE_MAX_LEN (LOG_MAX_LEN + 512) /* msg with prefix (time, file, func...). */
+#define LOG_FLUSH_INTERVAL 100               /* background thread flush interval (ms). */
+#define LOG_LOCK_RETRY_CNT 100               /* lock retry times in signal handler. */
+#define LOG_ALT_STACK_SIZE (64 * 1024)       /* signal stack, handle crash of stack overflow. */
+
+static pid_t g_pid = 0;            /* cache pid, getpid() is a syscall. */
+static Log* g_async_log = nullptr; /* there is only one async logger in a process. */
+
+/* force: give up waiting the lock, the holder may be interrupted by signal. */
+static bool lock_mutex(pthread_mutex_t* mutex, bool force) {
+    if (!force) {
+        pthread_mutex_lock(mutex);
+        return true;
+    }
+
+    for (int i = 0; i < LOG_LOCK_RETRY_CNT; i++) {
+        if (pthread_mutex_trylock(mutex) == 0) {
+            return true;
+        }
+        usleep(1000);
+    }
+    return false;
+}
+
+static void writev_all(int fd, struct iovec* iov, int cnt) {
+    while (cnt > 0) {
+        ssize_t n = writev(fd, iov, cnt);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return;
+        }
+
+        while (cnt > 0 && (size_t)n >= iov->iov_len) {
+            n -= iov->iov_len;
+            iov++;
+            cnt--;
+        }
+        if (cnt > 0) {
+            iov->iov_base = (char*)iov->iov_base + n;
+            iov->iov_len -= n;
+        }
+    }
+}
 
 Log::Log() : m_cur_level(LL_TRACE) {
+    pthread_cond_init(&m_cond, NULL);
+    pthread_mutex_init(&m_mutex, NULL);
+    pthread_mutex_init(&m_write_mutex, NULL);
+
+    if (g_pid == 0) {
+        g_pid = getpid();
+        pthread_atfork(on_fork_prepare, on_fork_parent, on_fork_child);
+    }
+}
+
+Log::~Log() {
+    stop_async();
+    pthread_cond_destroy(&m_cond);
+    pthread_mutex_destroy(&m_mutex);
+    pthread_mutex_destroy(&m_write_mutex);
 }
 
 bool Log::set_log_path(const char* path) {
@@ -81,8 +146,52 @@ bool Log::log_data(const char* file_name, int file_line,
     return log_raw(file_name, file_line, func_name, level, msg);
 }
 
+int Log::format_line(char* buf, size_t size, const char* file_name,
+                     int file_line, const char* func_name, int level, const char* msg) {
+    static const char levels[][10] = {"EMRG", "CRIT", "ALRT", "ERRO", "NOTI", "INFO", "WARN", "DBUG", "TRAC"};
+
+    /* format time by second once. */
+    static __thread time_t cache_secs = 0;
+    static __thread char cache_time[32];
+
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    if (tv.tv_sec != cache_secs) {
+        struct tm tm;
+        localtime_r(&tv.tv_sec, &tm);
+        strftime(cache_time, sizeof(cache_time), "[%Y-%m-%d %H:%M:%S.", &tm);
+        cache_secs = tv.tv_sec;
+    }
+
+    int len = snprintf(buf, size, "[%s][%s%d][%d]%s%03d][%s:%s:%d] %s\n",
+                       levels[level], m_is_manager ? "M" : "W", m_worker_index, (int)g_pid,
+                       cache_time, (int)tv.tv_usec / 1000, file_name, func_name, file_line, msg);
+    if (len < 0) {
+        return 0;
+    }
+    if ((size_t)len >= size) {
+        /* truncated, keep the line break. */
+        len = size - 1;
+        buf[len - 1] = '\n';
+    }
+    return len;
+}
+
 bool Log::log_raw(const char* file_name, int file_line,
                   const char* func_name, int level, const char* msg) {
+    char line[LOG_LINE_MAX_LEN];
+    int len = format_line(line, sizeof(line), file_name, file_line, func_name, level, msg);
+
+    if (m_is_async) {
+        if (level <= LL_CRIT) {
+            /* the process may exit right now, write out all lines. */
+            bool ok = ring_append(line, len);
+            flush();
+            return ok;
+        }
+        return ring_append(line, len);
+    }
+
     FILE* fp;
     bool is_log_file;
 
@@ -92,20 +201,7 @@ bool Log::log_raw(const char* file_name, int file_line,
     }
     is_log_file = !m_path.empty();
 
-    int off;
-    char buf[64] = {0};
-    struct timeval tv;
-    char levels[][10] = {"EMRG", "CRIT", "ALRT", "ERRO", "NOTI", "INFO", "WARN", "DBUG", "TRAC"};
-
-    time_t t = time(NULL);
-    struct tm* tm = localtime(&t);
-    gettimeofday(&tv, NULL);
-    off = strftime(buf, sizeof(buf), "[%Y-%m-%d %H:%M:%S.", tm);
-    snprintf(buf + off, sizeof(buf) - off, "%03d]", (int)tv.tv_usec / 1000);
-    fprintf(fp, "[%s][%s%d][%d]%s[%s:%s:%d] %s\n",
-            levels[level], m_is_manager ? "M" : "W", m_worker_index, (int)getpid(),
-            buf, file_name, func_name, file_line, msg);
-
+    fwrite(line, 1, len, fp);
     fflush(fp);
     if (is_log_file) {
         fclose(fp);
@@ -113,4 +209,256 @@ bool Log::log_raw(const char* file_name, int file_line,
     return true;
 }
 
-}  // namespace kim
\ No newline at end of file
+// async
+////////////////////////////////////////////////////////////
+
+bool Log::set_async(size_t ring_size) {
+    if (m_is_async) {
+        return true;
+    }
+
+    if (g_async_log != nullptr) {
+        return false;
+    }
+
+    size_t size = 4096;
+    while (size < ring_size) {
+        size <<= 1;
+    }
+
+    if (m_path.empty()) {
+        m_fd = STDOUT_FILENO;
+    } else {
+        m_fd = open(m_path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+        if (m_fd == -1) {
+            return false;
+        }
+    }
+
+    m_ring = (char*)malloc(size);
+    if (m_ring == nullptr) {
+        stop_async();
+        return false;
+    }
+    m_ring_size = size;
+    m_ring_head = m_ring_tail = 0;
+
+    m_stop_thread = false;
+    if (pthread_create(&m_thread, NULL, flush_thread, this) != 0) {
+        m_stop_thread = true;
+        stop_async();
+        return false;
+    }
+
+    /* flush buffered lines before crash. */
+    static bool is_signal_set = false;
+    if (!is_signal_set) {
+        stack_t ss;
+        ss.ss_sp = malloc(LOG_ALT_STACK_SIZE);
+        ss.ss_size = LOG_ALT_STACK_SIZE;
+        ss.ss_flags = 0;
+        if (ss.ss_sp != nullptr) {
+            sigaltstack(&ss, NULL);
+        }
+
+        struct sigaction act;
+        memset(&act, 0, sizeof(act));
+        sigemptyset(&act.sa_mask);
+        act.sa_flags = SA_RESETHAND | SA_ONSTACK;
+        act.sa_handler = &on_crash_signal;
+
+        int signals[] = {SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT};
+        for (unsigned int i = 0; i < sizeof(signals) / sizeof(int); i++) {
+            sigaction(signals[i], &act, 0);
+        }
+        is_signal_set = true;
+    }
+
+    m_is_async = true;
+    g_async_log = this;
+    return true;
+}
+
+void Log::stop_async() {
+    if (m_is_async) {
+        pthread_mutex_lock(&m_mutex);
+        m_stop_thread = true;
+        pthread_cond_signal(&m_cond);
+        pthread_mutex_unlock(&m_mutex);
+        pthread_join(m_thread, NULL);
+
+        flush();
+        m_is_async = false;
+    }
+
+    if (g_async_log == this) {
+        g_async_log = nullptr;
+    }
+
+    if (m_fd != -1 && m_fd != STDOUT_FILENO) {
+        close(m_fd);
+    }
+    m_fd = -1;
+
+    if (m_ring != nullptr) {
+        free(m_ring);
+        m_ring = nullptr;
+    }
+    m_ring_size = 0;
+}
+
+void Log::flush(bool force) {
+    if (m_ring != nullptr) {
+        ring_write_out(force);
+    }
+}
+
+bool Log::ring_append(const char* data, size_t len) {
+    pthread_mutex_lock(&m_mutex);
+
+    size_t used = m_ring_head - m_ring_tail;
+    if (used + len > m_ring_size) {
+        /* drop it, never block the event loop. */
+        m_dropped_cnt++;
+        pthread_mutex_unlock(&m_mutex);
+        return false;
+    }
+
+    size_t off = m_ring_head & (m_ring_size - 1);
+    size_t first = std::min(len, m_ring_size - off);
+    memcpy(m_ring + off, data, first);
+    if (len > first) {
+        memcpy(m_ring, data + first, len - first);
+    }
+    m_ring_head += len;
+
+    /* wake up the thread when the buffer is going to be full. */
+    bool is_wakeup = (used <= m_ring_size / 2 && used + len > m_ring_size / 2);
+    pthread_mutex_unlock(&m_mutex);
+
+    if (is_wakeup) {
+        pthread_cond_signal(&m_cond);
+    }
+    return true;
+}
+
+size_t Log::ring_write_out(bool force) {
+    /* force: the locks' holders may be interrupted by the signal,
+     * give up rather than write the region which may be written by others. */
+    if (!lock_mutex(&m_write_mutex, force)) {
+        return 0;
+    }
+    if (!lock_mutex(&m_mutex, force)) {
+        pthread_mutex_unlock(&m_write_mutex);
+        return 0;
+    }
+    uint64_t head = m_ring_head;
+    uint64_t tail = m_ring_tail;
+    uint64_t dropped = m_dropped_cnt - m_dropped_report;
+    m_dropped_report = m_dropped_cnt;
+    pthread_mutex_unlock(&m_mutex);
+
+    /* lines are written out of the lock, producers only append after head. */
+    size_t len = head - tail;
+    if (len > 0) {
+        int cnt = 0;
+        struct iovec iov[2];
+        size_t off = tail & (m_ring_size - 1);
+        size_t first = std::min(len, m_ring_size - off);
+        iov[cnt].iov_base = m_ring + off;
+        iov[cnt++].iov_len = first;
+        if (len > first) {
+            iov[cnt].iov_base = m_ring;
+            iov[cnt++].iov_len = len - first;
+        }
+        writev_all(m_fd, iov, cnt);
+    }
+
+    if (dropped > 0) {
+        char buf[128];
+        struct iovec iov;
+        iov.iov_base = buf;
+        iov.iov_len = snprintf(buf, sizeof(buf),
+                               "[WARN][%s%d][%d] log ring buffer is full, dropped %llu lines!\n",
+                               m_is_manager ? "M" : "W", m_worker_index, (int)g_pid,
+                               (unsigned long long)dropped);
+        writev_all(m_fd, &iov, 1);
+    }
+
+    if (lock_mutex(&m_mutex, force)) {
+        if (m_ring_tail < head) {
+            m_ring_tail = head;
+        }
+        pthread_mutex_unlock(&m_mutex);
+    }
+    pthread_mutex_unlock(&m_write_mutex);
+    return len;
+}
+
+void* Log::flush_thread(void* arg) {
+    Log* log = (Log*)arg;
+
+    /* signals are handled by main thread. */
+    sigset_t sigset;
+    sigfillset(&sigset);
+    pthread_sigmask(SIG_BLOCK, &sigset, NULL);
+
+    while (!log->m_stop_thread) {
+        pthread_mutex_lock(&log->m_mutex);
+        if (!log->m_stop_thread &&
+            log->m_ring_head - log->m_ring_tail <= log->m_ring_size / 2) {
+            struct timeval tv;
+            struct timespec ts;
+            gettimeofday(&tv, NULL);
+            long long usecs = tv.tv_usec + LOG_FLUSH_INTERVAL * 1000;
+            ts.tv_sec = tv.tv_sec + usecs / 1000000;
+            ts.tv_nsec = (usecs % 1000000) * 1000;
+            pthread_cond_timedwait(&log->m_cond, &log->m_mutex, &ts);
+        }
+        pthread_mutex_unlock(&log->m_mutex);
+
+        log->ring_write_out(false);
+    }
+
+    return nullptr;
+}
+
+void Log::on_fork_prepare() {
+    if (g_async_log != nullptr) {
+        pthread_mutex_lock(&g_async_log->m_write_mutex);
+        pthread_mutex_lock(&g_async_log->m_mutex);
+    }
+}
+
+void Log::on_fork_parent() {
+    if (g_async_log != nullptr) {
+        pthread_mutex_unlock(&g_async_log->m_mutex);
+        pthread_mutex_unlock(&g_async_log->m_write_mutex);
+    }
+}
+
+void Log::on_fork_child() {
+    g_pid = getpid();
+
+    /* no flush thread in child, and the buffered lines belong to parent,
+     * the logger falls back to sync mode. */
+    Log* log = g_async_log;
+    if (log != nullptr) {
+        /* the thread may be waiting on cond before fork, reset them. */
+        pthread_cond_init(&log->m_cond, NULL);
+        pthread_mutex_init(&log->m_mutex, NULL);
+        pthread_mutex_init(&log->m_write_mutex, NULL);
+        log->m_is_async = false;
+        log->m_stop_thread = true;
+        log->stop_async();
+    }
+}
+
+void Log::on_crash_signal(int sig) {
+    if (g_async_log != nullptr) {
+        g_async_log->flush(true);
+    }
+    raise(sig);
+}
+
+}  // namespace kim
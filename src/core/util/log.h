@@ -1,6 +1,8 @@
 #pragma once
 
+#include <pthread.h>
 #include <stdarg.h>
+#include <stdint.h>
 #include <stdio.h>
 
 #include <iostream>
@@ -24,7 +26,7 @@ class Log {
     };
 
     Log();
-    virtual ~Log() = default;
+    virtual ~Log();
 
    public:
     bool set_level(int level);
@@ -36,8 +38,34 @@ class Log {
     void set_worker_index(int index) { m_worker_index = index; }
     void set_process_type(bool is_manager) { m_is_manager = is_manager; }
 
+    /* async mode: lines are appended to a ring buffer (one per process),
+     * a background thread writes them to the log file with writev.
+     * call it after set_log_path. */
+    bool set_async(size_t ring_size = LOG_RING_SIZE);
+    bool is_async() { return m_is_async; }
+    /* write out the buffered lines in the caller's thread.
+     * force: give up if the lock can't be taken soon, only for the crash signal handler. */
+    void flush(bool force = false);
+    /* lines dropped because the ring buffer is full. */
+    uint64_t dropped_cnt() { return m_dropped_cnt; }
+
+    static const size_t LOG_RING_SIZE = 4 * 1024 * 1024;
+
    private:
     bool log_raw(const char* file_name, int file_line, const char* func_name, int level, const char* msg);
+    int format_line(char* buf, size_t len, const char* file_name,
+                    int file_line, const char* func_name, int level, const char* msg);
+
+    /* ring buffer. */
+    bool ring_append(const char* data, size_t len);
+    size_t ring_write_out(bool force); /* writev to file, return bytes written. */
+    void stop_async();
+
+    static void* flush_thread(void* arg);
+    static void on_fork_prepare();
+    static void on_fork_parent();
+    static void on_fork_child();
+    static void on_crash_signal(int sig);
 
    private:
     int m_cur_level;
@@ -46,6 +74,21 @@ class Log {
     /* process info. */
     int m_worker_index = -1;
     bool m_is_manager = false;
+
+    /* async. */
+    bool m_is_async = false;
+    volatile bool m_stop_thread = true;
+    int m_fd = -1;                /* log file, holding open in async mode. */
+    char* m_ring = nullptr;       /* ring buffer. */
+    size_t m_ring_size = 0;       /* power of 2. */
+    uint64_t m_ring_head = 0;     /* write position. */
+    uint64_t m_ring_tail = 0;     /* flush position. */
+    uint64_t m_dropped_cnt = 0;   /* total dropped lines. */
+    uint64_t m_dropped_report = 0;
+    pthread_t m_thread;
+    pthread_cond_t m_cond;
+    pthread_mutex_t m_mutex;       /* for ring's index. */
+    pthread_mutex_t m_write_mutex; /* only one writer writes the ring out. */
 };
 
 class Logger {
@@ -75,17 +75,32 @@ int SocketBuffer::write_fd(int fd, int& err) {
     return n;
 }
 
+/* readv's spill area. handlers run on shared coroutine stacks, a big
+ * stack frame makes every coroutine switch copy more stack data. */
+static char* spill_buffer() {
+    static thread_local char* buffer = nullptr;
+    if (buffer == nullptr) {
+        buffer = (char*)malloc(SocketBuffer::BUFFER_EXTRA_READ);
+    }
+    return buffer;
+}
+
 int SocketBuffer::read_fd(int fd, int& err) {
-    char extrabuf[32768];
+    char* extrabuf = spill_buffer();
     struct iovec vec[2];
+
+    if (extrabuf == nullptr && !ensure_writeable(DEFAULT_BUFFER_SIZE)) {
+        err = errno = ENOMEM;
+        return -1;
+    }
     size_t writable = writeable_len();
 
     vec[0].iov_base = m_buffer + m_write_idx;
     vec[0].iov_len = writable;
     vec[1].iov_base = extrabuf;
-    vec[1].iov_len = sizeof(extrabuf);
+    vec[1].iov_len = BUFFER_EXTRA_READ;
 
-    int n = readv(fd, vec, writable > sizeof(extrabuf) ? 1 : 2);
+    int n = readv(fd, vec, (extrabuf == nullptr || writable > BUFFER_EXTRA_READ) ? 1 : 2);
     if (n < 0) {
         err = errno;
     } else if ((size_t)n <= writable) {
@@ -13,6 +13,8 @@
 #include <cstring>
 #include <string>
 
+#include "buffer_pool.h"
+
 /**
  *
  *       +-------------------+------------------+------------------+
@@ -33,16 +35,18 @@ class SocketBuffer {
     size_t m_buffer_len = 0;   // raw buffer length
     size_t m_write_idx = 0;    // current write index.
     size_t m_read_idx = 0;     // current read index.
+    size_t m_block_len = 0;    // block length from buffer pool.
 
    public:
     static const size_t BUFFER_MAX_READ = 8192;
     static const size_t DEFAULT_BUFFER_SIZE = 32;
+    static const size_t BUFFER_EXTRA_READ = 32768;
 
     inline SocketBuffer() {}
     inline SocketBuffer(size_t size) { ensure_writeable(size); }
     inline ~SocketBuffer() {
         if (m_buffer != nullptr) {
-            free(m_buffer);
+            BufferPool::instance()->free(m_buffer, m_block_len);
             m_buffer = nullptr;
         }
     }
@@ -56,6 +60,11 @@ class SocketBuffer {
     inline bool is_writeable() { return m_buffer_len > m_write_idx; }
     inline size_t readable_len() { return is_readable() ? m_write_idx - m_read_idx : 0; }
     inline size_t writeable_len() { return is_writeable() ? m_buffer_len - m_write_idx : 0; }
+    /* max bytes which read_fd() can read once, less means the socket has been drained. */
+    inline size_t read_fd_limit() {
+        size_t writable = writeable_len();
+        return (writable > BUFFER_EXTRA_READ) ? writable : writable + BUFFER_EXTRA_READ;
+    }
 
     // recovery writebale buffer and alreay readed buffer.
     inline size_t compact(size_t size) {
@@ -63,28 +72,17 @@ class SocketBuffer {
             return 0;
         }
 
-        uint32_t total = capacity();
-        uint32_t readable_bytes = readable_len();
-
-        char* new_buffer = nullptr;
-        if (readable_bytes > 0) {
-            new_buffer = (char*)malloc(readable_bytes);
-            if (new_buffer == nullptr) {
-                return 0;
-            }
-            memcpy(new_buffer, m_buffer + m_read_idx, readable_bytes);
+        /* the readable data would be copied to a block of the same size. */
+        size_t readable = readable_len();
+        if (readable > 0 && BufferPool::block_size(readable) >= m_block_len) {
+            return 0;
         }
 
-        if (m_buffer != nullptr) {
-            free(m_buffer);
-            m_buffer = nullptr;
+        size_t total = capacity();
+        if (!reset_block(readable)) {
+            return 0;
         }
-
-        m_buffer = new_buffer;
-        m_read_idx = 0;
-        m_write_idx = readable_bytes;
-        m_buffer_len = readable_bytes;
-        return (total - readable_bytes);
+        return (total - capacity());
     }
 
     inline bool ensure_writeable(size_t min) {
@@ -93,33 +91,19 @@ class SocketBuffer {
             return true;
         }
 
-        // not enough space to write, then alloc more.
-        size_t cap = capacity();
-        if (cap > BUFFER_MAX_READ) {
-            compact(min);
-        }
-
-        if (cap == 0) {
-            cap = DEFAULT_BUFFER_SIZE;
+        // readed bytes make enough space, move the readable data to the front.
+        size_t readable = readable_len();
+        if (m_buffer_len - readable >= min) {
+            DiscardReadedBytes();
+            return true;
         }
 
-        size_t min_cap = write_index() + min;
-        while (cap < min_cap) {
+        // not enough space to write, then alloc more.
+        size_t cap = (m_buffer_len == 0) ? DEFAULT_BUFFER_SIZE : m_buffer_len;
+        while (cap < readable + min) {
             cap <<= 1;
         }
-
-        char* tmp = (char*)malloc(cap);
-        if (tmp != nullptr) {
-            memcpy(tmp, m_buffer + m_read_idx, readable_len());
-            free(m_buffer);
-            m_buffer = tmp;
-            m_buffer_len = cap;
-            m_write_idx = readable_len();
-            m_read_idx = 0;
-            return true;
-        }
-
-        return false;
+        return reset_block(cap);
     }
 
     inline char* raw_write_buffer() { return m_buffer + m_write_idx; }
@@ -225,6 +209,35 @@ class SocketBuffer {
     int write_fd(int fd, int& err);
 
     inline std::string ToString() { return std::string(m_buffer + m_read_idx, readable_len()); }
+
+   private:
+    // move the readable data into a new block from pool, size 0: release the block.
+    inline bool reset_block(size_t size) {
+        size_t readable = readable_len();
+        size_t block_len = 0;
+        char* block = nullptr;
+
+        if (size > 0) {
+            block = BufferPool::instance()->alloc(size, block_len);
+            if (block == nullptr) {
+                return false;
+            }
+            if (readable > 0) {
+                memcpy(block, m_buffer + m_read_idx, readable);
+            }
+        }
+
+        if (m_buffer != nullptr) {
+            BufferPool::instance()->free(m_buffer, m_block_len);
+        }
+
+        m_buffer = block;
+        m_block_len = block_len;
+        m_buffer_len = block_len;
+        m_read_idx = 0;
+        m_write_idx = readable;
+        return true;
+    }
 };
 
 }  // namespace kim
@@ -7,9 +7,11 @@
 #include <ctype.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <sched.h>
 #include <stdarg.h>
 #include <stdlib.h>
 #include <sys/resource.h>
+#include <sys/syscall.h>
 #include <sys/time.h>
 #include <unistd.h>
 
@@ -118,6 +120,66 @@ bool json_to_proto(const std::string& json, google::protobuf::Message& message)
     return JsonStringToMessage(json, &message).ok();
 }
 
+bool set_cpu_affinity(const std::vector<int>& cpus) {
+    if (cpus.empty()) {
+        return false;
+    }
+
+    cpu_set_t mask;
+    CPU_ZERO(&mask);
+    for (auto cpu : cpus) {
+        if (cpu < 0 || cpu >= CPU_SETSIZE) {
+            return false;
+        }
+        CPU_SET(cpu, &mask);
+    }
+    return sched_setaffinity(0, sizeof(mask), &mask) == 0;
+}
+
+bool get_numa_node_cpus(int node, std::vector<int>& cpus) {
+    char path[MAX_PATH];
+    snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+
+    std::ifstream is(path);
+    if (!is.good()) {
+        return false;
+    }
+
+    /* cpulist format: "0-3,8-11". */
+    std::string line;
+    std::getline(is, line);
+
+    std::vector<std::string> ranges;
+    split_str(line, ranges, ",");
+    for (auto& range : ranges) {
+        int first = 0, last = 0;
+        int n = sscanf(range.c_str(), "%d-%d", &first, &last);
+        if (n == 1) {
+            last = first;
+        } else if (n != 2 || last < first) {
+            return false;
+        }
+        for (int i = first; i <= last; i++) {
+            cpus.push_back(i);
+        }
+    }
+    return !cpus.empty();
+}
+
+bool set_numa_preferred(int node) {
+#if defined(SYS_set_mempolicy)
+    /* MPOL_PREFERRED (linux/mempolicy.h), alloc pages on the node first. */
+    const int mpol_preferred = 1;
+    if (node < 0 || node >= (int)(sizeof(unsigned long) * 8)) {
+        return false;
+    }
+    unsigned long mask = 1UL << node;
+    return syscall(SYS_set_mempolicy, mpol_preferred, &mask, sizeof(mask) * 8) == 0;
+#else
+    return false;
+#endif
+}
+
 void daemonize(void) {
     int fd;
 
@@ -29,6 +29,11 @@ bool proto_to_json(const google::protobuf::Message& message, std::string& json);
 bool json_file_to_proto(const std::string& file, google::protobuf::Message& message);
 bool json_to_proto(const std::string& json, google::protobuf::Message& message);
 
+/* cpu & numa. */
+bool set_cpu_affinity(const std::vector<int>& cpus);
+bool get_numa_node_cpus(int node, std::vector<int>& cpus); /* parse sysfs node's cpulist. */
+bool set_numa_preferred(int node);                          /* set_mempolicy without libnuma. */
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -10,6 +10,7 @@
 namespace kim {
 
 void* Worker::m_signal_user_data = nullptr;
+volatile sig_atomic_t Worker::m_stop_signal = 0;
 
 Worker::Worker(const std::string& name) {
     srand((unsigned)time(NULL));
@@ -50,6 +51,7 @@ bool Worker::init(const worker_info_t* info, const std::string& config_path) {
     m_worker_info.fctrl = info->fctrl;
     m_worker_info.fdata = info->fdata;
     m_worker_info.index = info->index;
+    m_worker_info.gate_fd = info->gate_fd;
     m_worker_info.pid = getpid();
 
     LOG_INFO("init worker, index: %d, fctrl fd: %d, fdata: %d",
@@ -61,6 +63,7 @@ bool Worker::init(const worker_info_t* info, const std::string& config_path) {
     }
 
     load_signals();
+    load_cpu_affinity();
 
     if (!load_network()) {
         LOG_ERROR("create network failed!");
@@ -92,6 +95,11 @@ bool Worker::load_logger() {
         return false;
     }
 
+    if (m_config->is_log_async() && !m_logger->set_async()) {
+        LOG_ERROR("set async log failed!");
+        return false;
+    }
+
     m_logger->set_process_type(false);
     m_logger->set_worker_index(m_worker_info.index);
 
@@ -99,6 +107,33 @@ bool Worker::load_logger() {
     return true;
 }
 
+void Worker::load_cpu_affinity() {
+    auto cpu = m_config->worker_cpu(m_worker_info.index);
+    if (cpu >= 0) {
+        if (set_cpu_affinity({cpu})) {
+            LOG_INFO("worker bind cpu: %d", cpu);
+        } else {
+            LOG_WARN("worker bind cpu failed! cpu: %d, error: %s", cpu, strerror(errno));
+        }
+    }
+
+    /* memory is allocated on the local numa node first. */
+    auto node = m_config->worker_numa_node(m_worker_info.index);
+    if (node >= 0) {
+        /* no cpu for worker, run on the node's cpus. */
+        std::vector<int> cpus;
+        if (cpu < 0 && get_numa_node_cpus(node, cpus) && !set_cpu_affinity(cpus)) {
+            LOG_WARN("worker bind numa node's cpus failed! node: %d", node);
+        }
+
+        if (set_numa_preferred(node)) {
+            LOG_INFO("worker prefers numa node: %d", node);
+        } else {
+            LOG_WARN("worker set numa node failed! node: %d, error: %s", node, strerror(errno));
+        }
+    }
+}
+
 bool Worker::load_network() {
     LOG_TRACE("load network!");
 
@@ -109,7 +144,7 @@ bool Worker::load_network() {
     }
 
     if (!m_net->create_w(m_config, m_worker_info.fctrl.fd, m_worker_info.fdata.fd,
-                         m_worker_info.index)) {
+                         m_worker_info.index, m_worker_info.gate_fd)) {
         LOG_ERROR("init network failed!");
         return false;
     }
@@ -126,6 +161,7 @@ void Worker::run() {
 
 void Worker::on_repeat_timer() {
     co_enable_hook_sys();
+    handle_signals();
     if (m_net != nullptr) {
         m_net->on_timer();
     }
@@ -152,12 +188,25 @@ void Worker::signal_handler(int sig) {
 }
 
 void Worker::signal_handler_event(int sig) {
+    /* async-signal-safe calls only, the interrupted code may hold the logger's lock. */
+    m_stop_signal = sig;
+}
+
+void Worker::handle_signals() {
+    if (!m_stop_signal) {
+        return;
+    }
+
+    int sig = m_stop_signal;
     std::string name = m_config->worker_name(m_worker_info.index);
     if (sig == SIGUSR1 || sig == SIGINT) {
         LOG_INFO("%s terminated by signal %d!", name.c_str(), sig);
     } else {
         LOG_CRIT("%s terminated by signal %d!", name.c_str(), sig);
     }
+    if (m_logger != nullptr) {
+        m_logger->flush();
+    }
     _exit(EXIT_CHILD);
 }
 
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <signal.h>
+
 #include "network.h"
 #include "nodes.h"
 #include "timer.h"
@@ -21,11 +23,13 @@ class Worker : CoTimer {
    private:
     bool load_logger();
     bool load_network();
+    void load_cpu_affinity(); /* pin worker to cpu & numa node. */
     bool load_sys_config(const std::string& config_path);
 
-    /* signals. */
+    /* signals, the handler only sets the flag, it is handled in the timer. */
     void load_signals();
     void signal_handler_event(int sig);
+    void handle_signals();
     static void signal_handler(int sig);
 
    private:
@@ -34,6 +38,7 @@ class Worker : CoTimer {
     std::shared_ptr<SysConfig> m_config = nullptr; /* system config data. */
     worker_info_t m_worker_info;                   /* current worker info. */
     static void* m_signal_user_data;
+    static volatile sig_atomic_t m_stop_signal; /* stop signal arrived, 0: none. */
 };
 
 }  // namespace kim
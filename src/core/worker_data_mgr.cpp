@@ -1,5 +1,7 @@
 #include "worker_data_mgr.h"
 
+#include <algorithm>
+
 #include "server.h"
 
 namespace kim {
@@ -13,6 +15,7 @@ WorkerDataMgr::~WorkerDataMgr() {
         SAFE_DELETE(it.second);
     }
     m_workers.clear();
+    m_worker_list.clear();
     m_itr_worker = m_workers.end();
     m_index_workers.clear();
 }
@@ -29,13 +32,14 @@ bool WorkerDataMgr::add_worker_info(int index, int pid, const fd_t& fctrl, const
         del_worker_info(pid);
     }
 
-    auto info = new worker_info_t{pid, index, fctrl, fdata};
+    auto info = new worker_info_t{pid, index, fctrl, fdata, "", Payload(), 0, -1};
     if (info == nullptr) {
         LOG_ERROR("alloc worker_info falied!");
         return false;
     }
 
     m_workers[pid] = info;
+    m_worker_list.push_back(info);
     m_itr_worker = m_workers.begin();
     m_index_workers[index] = info;
     LOG_INFO("add worker info done! pid: %d, index: %d", pid, index);
@@ -73,6 +77,7 @@ bool WorkerDataMgr::del_worker_info(int pid) {
 
     worker_info_t* info = it->second;
     m_index_workers.erase(info->index);
+    m_worker_list.erase(std::remove(m_worker_list.begin(), m_worker_list.end(), info), m_worker_list.end());
     SAFE_DELETE(info);
     m_workers.erase(it);
     LOG_INFO("del worker info, pid: %d", pid);
@@ -97,16 +102,101 @@ bool WorkerDataMgr::get_worker_channel(int pid, int* chs) {
     return true;
 }
 
+bool WorkerDataMgr::set_balance(const std::string& balance) {
+    if (balance.empty() || strcasecmp(balance.c_str(), "round_robin") == 0) {
+        m_balance = BALANCE::ROUND_ROBIN;
+    } else if (strcasecmp(balance.c_str(), "least_conn") == 0) {
+        m_balance = BALANCE::LEAST_CONN;
+    } else if (strcasecmp(balance.c_str(), "p2c") == 0) {
+        m_balance = BALANCE::P2C;
+    } else {
+        LOG_ERROR("invalid worker balance: %s", balance.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool WorkerDataMgr::update_payload(const Payload& pl) {
+    auto info = get_worker_info_by_index(pl.worker_index());
+    if (info == nullptr) {
+        return false;
+    }
+    info->payload = pl;
+    return true;
+}
+
 int WorkerDataMgr::get_next_worker_data_fd() {
     if (m_workers.empty()) {
         LOG_ERROR("workers is empty!");
         return -1;
     }
+
+    worker_info_t* info = nullptr;
+    switch (m_balance) {
+        case BALANCE::LEAST_CONN: {
+            info = get_least_conn();
+            break;
+        }
+        case BALANCE::P2C: {
+            info = get_p2c();
+            break;
+        }
+        default: {
+            info = get_next_round_robin();
+            break;
+        }
+    }
+
+    info->sent_fd_cnt++;
+    return info->fdata.fd;
+}
+
+worker_info_t* WorkerDataMgr::get_next_round_robin() {
     m_itr_worker++;
     if (m_itr_worker == m_workers.end()) {
         m_itr_worker = m_workers.begin();
     }
-    return m_itr_worker->second->fdata.fd;
+    return m_itr_worker->second;
+}
+
+uint64_t WorkerDataMgr::conn_load(const worker_info_t* info) {
+    /* the report counts the fds received before it, the later ones are still in flight. */
+    uint64_t recv_cnt = info->payload.recv_fd_cnt();
+    uint64_t in_flight = (info->sent_fd_cnt > recv_cnt) ? info->sent_fd_cnt - recv_cnt : 0;
+    return info->payload.conn_cnt() + in_flight;
+}
+
+bool WorkerDataMgr::is_less_load(const worker_info_t* a, const worker_info_t* b) {
+    uint64_t ca = conn_load(a);
+    uint64_t cb = conn_load(b);
+    if (ca != cb) {
+        return ca < cb;
+    }
+    return a->payload.co_cnt() < b->payload.co_cnt();
+}
+
+worker_info_t* WorkerDataMgr::get_least_conn() {
+    worker_info_t* least = nullptr;
+    for (auto info : m_worker_list) {
+        if (least == nullptr || is_less_load(info, least)) {
+            least = info;
+        }
+    }
+    return least;
+}
+
+worker_info_t* WorkerDataMgr::get_p2c() {
+    size_t cnt = m_worker_list.size();
+    if (cnt == 1) {
+        return m_worker_list[0];
+    }
+
+    size_t a = rand() % cnt;
+    size_t b = rand() % (cnt - 1);
+    if (b >= a) {
+        b++;
+    }
+    return is_less_load(m_worker_list[b], m_worker_list[a]) ? m_worker_list[b] : m_worker_list[a];
 }
 
 }  // namespace kim
\ No newline at end of file
@@ -13,13 +13,25 @@ typedef struct worker_info_s {
     fd_t fdata;            /* socketpair for parent and child. */
     std::string work_path; /* process work path. */
     Payload payload;       /* payload info. */
+    uint64_t sent_fd_cnt;  /* client fds sent to worker, the ones not in payload's recv_fd_cnt are in flight. */
+    int gate_fd;           /* reuseport listen fd created by manager, -1 if not used. */
 } worker_info_t;
 
 class WorkerDataMgr : public Logger {
    public:
+    /* policy to choose a worker for a new client fd. */
+    enum class BALANCE {
+        ROUND_ROBIN = 0,
+        LEAST_CONN = 1, /* least connections. */
+        P2C = 2,        /* power of two choices. */
+    };
+
     WorkerDataMgr(std::shared_ptr<Log> logger);
     virtual ~WorkerDataMgr();
 
+    bool set_balance(const std::string& balance);
+    BALANCE balance() { return m_balance; }
+
    public:
     bool del_worker_info(int pid);
     worker_info_t* get_worker_info_by_pid(int pid);
@@ -28,11 +40,22 @@ class WorkerDataMgr : public Logger {
     const std::unordered_map<int, worker_info_t*>& get_infos() const { return m_workers; }
 
     int get_next_worker_data_fd();
+    bool update_payload(const Payload& pl);
     bool get_worker_channel(int pid, int* chs);
     int get_worker_index(int pid);
     int get_worker_data_fd(int worker_index);
 
    private:
+    worker_info_t* get_next_round_robin();
+    worker_info_t* get_least_conn();
+    worker_info_t* get_p2c();
+    /* live connections: last reported + fds in flight (sent but not reported yet). */
+    uint64_t conn_load(const worker_info_t* info);
+    bool is_less_load(const worker_info_t* a, const worker_info_t* b);
+
+   private:
+    BALANCE m_balance = BALANCE::ROUND_ROBIN;
+    std::vector<worker_info_t*> m_worker_list; /* for random access. */
     /* key: pid. */
     std::unordered_map<int, worker_info_t*> m_workers;
     std::unordered_map<int, worker_info_t*>::iterator m_itr_worker;
@@ -5,25 +5,34 @@ MUDULE_CREATE(MoudleGate)
 namespace kim {
 
 int MoudleGate::filter_request(std::shared_ptr<Msg> req) {
-    auto ack = std::make_shared<Msg>();
-    auto ret = net()->relay_to_node("logic", req->body()->data(), req, ack);
+    /* the private head's route key routes the msg without reading its body. */
+    std::string obj;
+    if (req->route_key() != 0) {
+        obj = std::to_string(req->route_key());
+    } else if (!req->body_data(obj)) {
+        LOG_ERROR("decode msg body failed! cmd: %d, seq: %u", req->head()->cmd(), req->head()->seq());
+        return net()->send_ack(req, ERR_PACKET_DECODE_FAILED, "decode msg body failed!");
+    }
+
+    /* pass-through: relay the undecoded body, the ack's body is not decoded too. */
+    auto ack = net()->new_msg();
+    ack->set_raw(req->is_raw());
+
+    auto ret = net()->relay_to_node("logic", obj, req, ack);
     if (ret != ERR_OK) {
         ret = net()->send_ack(req, ret, "relay to node failed!");
     } else {
         ret = net()->send_to(req->ft(), ack);
     }
 
-    LOG_DEBUG("ack, cmd: %d, seq: %u, body len: %d, error: %d, errstr: %s, data: %s",
-              ack->head()->cmd(), ack->head()->seq(), ack->head()->len(),
-              ack->body()->mutable_rsp_result()->code(),
-              ack->body()->mutable_rsp_result()->msg().c_str(),
-              ack->body()->data().c_str());
+    LOG_DEBUG("ack, cmd: %d, seq: %u, body len: %d, raw: %d, error: %d",
+              ack->head()->cmd(), ack->head()->seq(), ack->head()->len(), ack->is_raw(), ret);
 
-    LOG_DEBUG("req, cmd: %d, seq: %u, len: %d, body data: <%s>",
+    LOG_DEBUG("req, cmd: %d, seq: %u, len: %d, raw: %d, obj: <%s>",
               req->head()->cmd(), req->head()->seq(),
-              req->head()->len(), req->body()->data().c_str());
+              req->head()->len(), req->is_raw(), obj.c_str());
 
     return ret;
 }
 
-}  // namespace kim
\ No newline at end of file
+}  // namespace kim
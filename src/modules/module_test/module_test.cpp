@@ -51,15 +51,13 @@ int MoudleTest::on_test_redis(std::shared_ptr<Msg> req) {
     print_cmd_info(req);
 
     int id = 1;
-    char cmd[1024];
     const char* node = "test";
     const char* key = "key";
-    const char* val = "value";
+    std::string val = format_str("value:%d", id);
     redisReply* reply = nullptr;
 
     /* write redis. */
-    snprintf(cmd, sizeof(cmd), "set %s %s:%d", key, val, id);
-    auto ret = net()->redis_mgr()->exec_cmd(node, cmd, &reply);
+    auto ret = net()->redis_mgr()->exec_cmd_args(node, &reply, "set", key, val);
     if (ret != REDIS_OK || reply == nullptr) {
         ret = ERR_REDIS_WRITE_FAILED;
         LOG_ERROR("write redis failed!");
@@ -67,11 +65,10 @@ int MoudleTest::on_test_redis(std::shared_ptr<Msg> req) {
     }
     freeReplyObject(reply);
 
-    LOG_DEBUG("write redis done! cmd: %s", cmd);
+    LOG_DEBUG("write redis done! key: %s, value: %s", key, val.c_str());
 
     /* read redis. */
-    snprintf(cmd, sizeof(cmd), "get %s", key);
-    ret = net()->redis_mgr()->exec_cmd(node, cmd, &reply);
+    ret = net()->redis_mgr()->exec_cmd_args(node, &reply, "get", key);
     if (ret != REDIS_OK || reply == nullptr) {
         LOG_ERROR("read redis failed!");
         ret = ERR_REDIS_READ_FAILED;
@@ -79,7 +76,7 @@ int MoudleTest::on_test_redis(std::shared_ptr<Msg> req) {
     }
     freeReplyObject(reply);
 
-    LOG_DEBUG("read redis done! cmd: %s", cmd);
+    LOG_DEBUG("read redis done! key: %s", key);
     return net()->send_ack(req, ERR_OK, "ok", "test redis done!");
 }
 
@@ -0,0 +1,60 @@
+#pragma once
+
+/* helpers for redis's unit tests, which run without redis server:
+ * cmds are encoded as hiredis does, replies are allocated as hiredis does,
+ * free them by freeReplyObject. */
+
+#include <hiredis/hiredis.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+int g_fail_cnt = 0;
+
+#define TEST_CHECK(expr)                                         \
+    if (!(expr)) {                                               \
+        printf("check failed! line: %d, %s\n", __LINE__, #expr); \
+        g_fail_cnt++;                                            \
+    }
+
+std::string format_cmd(const std::vector<std::string>& args) {
+    std::vector<const char*> argv;
+    std::vector<size_t> argvlen;
+    for (const auto& arg : args) {
+        argv.push_back(arg.c_str());
+        argvlen.push_back(arg.size());
+    }
+
+    char* cmd = nullptr;
+    int len = redisFormatCommandArgv(&cmd, argv.size(), argv.data(), argvlen.data());
+    std::string s(cmd, len > 0 ? len : 0);
+    redisFreeCommand(cmd);
+    return s;
+}
+
+redisReply* new_reply(int type, size_t elements = 0) {
+    redisReply* r = (redisReply*)calloc(1, sizeof(redisReply));
+    r->type = type;
+    if (elements > 0) {
+        r->elements = elements;
+        r->element = (redisReply**)calloc(elements, sizeof(redisReply*));
+    }
+    return r;
+}
+
+redisReply* new_integer(long long integer) {
+    redisReply* r = new_reply(REDIS_REPLY_INTEGER);
+    r->integer = integer;
+    return r;
+}
+
+redisReply* new_string(const std::string& str, int type = REDIS_REPLY_STRING) {
+    redisReply* r = new_reply(type);
+    r->str = (char*)malloc(str.size() + 1);
+    memcpy(r->str, str.c_str(), str.size() + 1);
+    r->len = str.size();
+    return r;
+}
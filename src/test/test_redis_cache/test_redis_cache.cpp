@@ -0,0 +1,181 @@
+#include "../common/common.h"
+#include "../common/redis_test.h"
+#include "redis/redis_cache.h"
+
+bool is_cacheable(const std::string& cmd, std::string& key) {
+    return RedisCache::is_cacheable(cmd.c_str(), cmd.size(), key);
+}
+
+/* fill the cache as RedisMgr does. */
+void fill(RedisCache& cache, const std::string& key, const std::string& cmd, const std::string& value) {
+    auto ticket = cache.begin_fill(key);
+    redisReply* r = new_string(value);
+    if (cache.end_fill(key, ticket)) {
+        cache.set(key, cmd.c_str(), cmd.size(), r);
+    }
+    freeReplyObject(r);
+}
+
+/* the cached reply's string, "<miss>" if it is not cached. */
+std::string get(RedisCache& cache, const std::string& cmd) {
+    redisReply* r = cache.get(cmd.c_str(), cmd.size());
+    if (r == nullptr) {
+        return "<miss>";
+    }
+    std::string s(r->str, r->len);
+    freeReplyObject(r);
+    return s;
+}
+
+void test_cacheable() {
+    std::string key;
+    TEST_CHECK(is_cacheable(format_cmd({"GET", "k1"}), key) && key == "k1");
+    TEST_CHECK(is_cacheable(format_cmd({"hget", "h1", "f1"}), key) && key == "h1");
+    TEST_CHECK(is_cacheable(format_cmd({"ZRANGE", "z1", "0", "-1"}), key) && key == "z1");
+    TEST_CHECK(!is_cacheable(format_cmd({"SET", "k1", "v1"}), key));
+    TEST_CHECK(!is_cacheable(format_cmd({"GETSET", "k1", "v1"}), key));
+    TEST_CHECK(!is_cacheable(format_cmd({"PING"}), key));
+    TEST_CHECK(!is_cacheable("GET k1\r\n", key));
+}
+
+void test_get_set() {
+    RedisCache cache(1024 * 1024);
+    auto get_k1 = format_cmd({"GET", "k1"});
+    auto hget_k1 = format_cmd({"HGET", "k1", "f1"});
+
+    TEST_CHECK(get(cache, get_k1) == "<miss>");
+    fill(cache, "k1", get_k1, "v1");
+    fill(cache, "k1", hget_k1, "f1v1");
+    TEST_CHECK(get(cache, get_k1) == "v1");
+    TEST_CHECK(get(cache, hget_k1) == "f1v1");
+
+    /* the same cmd's reply is replaced. */
+    fill(cache, "k1", get_k1, "v2");
+    TEST_CHECK(get(cache, get_k1) == "v2");
+    TEST_CHECK(cache.stats().entries == 2);
+
+    /* error reply is not cached. */
+    auto get_k2 = format_cmd({"GET", "k2"});
+    redisReply* r = new_string("ERR", REDIS_REPLY_ERROR);
+    cache.set("k2", get_k2.c_str(), get_k2.size(), r);
+    freeReplyObject(r);
+    TEST_CHECK(get(cache, get_k2) == "<miss>");
+
+    /* all cmds of the key are invalidated. */
+    cache.invalidate("k1", 2);
+    TEST_CHECK(get(cache, get_k1) == "<miss>");
+    TEST_CHECK(get(cache, hget_k1) == "<miss>");
+    TEST_CHECK(cache.stats().entries == 0 && cache.stats().memory == 0);
+    TEST_CHECK(cache.stats().hits == 3 && cache.stats().misses == 4);
+}
+
+void test_copy_reply() {
+    redisReply* r = (redisReply*)calloc(1, sizeof(redisReply));
+    r->type = REDIS_REPLY_ARRAY;
+    r->elements = 2;
+    r->element = (redisReply**)calloc(2, sizeof(redisReply*));
+    r->element[0] = new_string("a");
+    r->element[1] = new_string("bc");
+
+    redisReply* c = RedisCache::copy_reply(r);
+    TEST_CHECK(c != r && c->type == REDIS_REPLY_ARRAY && c->elements == 2);
+    TEST_CHECK(c->element != r->element && c->element[1] != r->element[1]);
+    TEST_CHECK(c->element[1]->len == 2 && strcmp(c->element[1]->str, "bc") == 0);
+    freeReplyObject(r);
+    freeReplyObject(c);
+}
+
+void test_lru() {
+    RedisCache cache(4 * 1024);
+    std::string value(256, 'v');
+
+    for (int i = 0; i < 20; i++) {
+        auto key = format_str("k%d", i);
+        fill(cache, key, format_cmd({"GET", key}), value);
+        /* k0 is the most recently used, it is not evicted. */
+        TEST_CHECK(get(cache, format_cmd({"GET", "k0"})) == value);
+    }
+
+    TEST_CHECK(cache.stats().evictions > 0);
+    TEST_CHECK(cache.stats().memory <= 4 * 1024);
+    TEST_CHECK(get(cache, format_cmd({"GET", "k1"})) == "<miss>");
+    TEST_CHECK(get(cache, format_cmd({"GET", "k19"})) == value);
+
+    /* too large to be cached. */
+    fill(cache, "big", format_cmd({"GET", "big"}), std::string(4 * 1024, 'v'));
+    TEST_CHECK(get(cache, format_cmd({"GET", "big"})) == "<miss>");
+}
+
+void test_fill_race() {
+    RedisCache cache(1024 * 1024);
+    auto cmd = format_cmd({"GET", "k1"});
+    redisReply* r = new_string("old");
+
+    /* invalidated while the reply is on the way, it is not cached. */
+    auto ticket = cache.begin_fill("k1");
+    cache.invalidate("k1", 2);
+    TEST_CHECK(!cache.end_fill("k1", ticket));
+
+    /* cleared (invalidation conn lost) while filling. */
+    ticket = cache.begin_fill("k1");
+    cache.clear();
+    TEST_CHECK(!cache.end_fill("k1", ticket));
+
+    /* concurrent fills of the key, the dirty flag lasts until the last one ends. */
+    auto t1 = cache.begin_fill("k1");
+    auto t2 = cache.begin_fill("k1");
+    cache.invalidate("k1", 2);
+    TEST_CHECK(!cache.end_fill("k1", t1));
+    TEST_CHECK(!cache.end_fill("k1", t2));
+
+    ticket = cache.begin_fill("k1");
+    TEST_CHECK(cache.end_fill("k1", ticket));
+    cache.set("k1", cmd.c_str(), cmd.size(), r);
+    TEST_CHECK(get(cache, cmd) == "old");
+
+    freeReplyObject(r);
+}
+
+void test_invalidate_cmd() {
+    RedisCache cache(1024 * 1024);
+    auto get_k1 = format_cmd({"GET", "k1"});
+    auto get_k2 = format_cmd({"GET", "k2"});
+    auto get_k3 = format_cmd({"GET", "k3"});
+    fill(cache, "k1", get_k1, "v1");
+    fill(cache, "k2", get_k2, "v2");
+    fill(cache, "k3", get_k3, "v3");
+
+    /* the write's keys are dropped before redis's invalidation arrives. */
+    auto set_k1 = format_cmd({"SET", "k1", "v1.1"});
+    cache.invalidate_cmd(set_k1.c_str(), set_k1.size());
+    TEST_CHECK(get(cache, get_k1) == "<miss>");
+    TEST_CHECK(get(cache, get_k2) == "v2");
+
+    /* multi keys' cmd. */
+    auto del = format_cmd({"DEL", "k2", "k3"});
+    cache.invalidate_cmd(del.c_str(), del.size());
+    TEST_CHECK(get(cache, get_k2) == "<miss>");
+    TEST_CHECK(get(cache, get_k3) == "<miss>");
+
+    /* the fill in flight read the old value. */
+    auto ticket = cache.begin_fill("k1");
+    cache.invalidate_cmd(set_k1.c_str(), set_k1.size());
+    TEST_CHECK(!cache.end_fill("k1", ticket));
+    TEST_CHECK(cache.stats().invalidations == 0);
+}
+
+int main(int argc, char** argv) {
+    test_cacheable();
+    test_get_set();
+    test_copy_reply();
+    test_lru();
+    test_fill_race();
+    test_invalidate_cmd();
+
+    if (g_fail_cnt > 0) {
+        printf("test redis cache failed! fail cnt: %d\n", g_fail_cnt);
+        return -1;
+    }
+    printf("test redis cache done!\n");
+    return 0;
+}
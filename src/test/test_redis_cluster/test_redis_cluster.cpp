@@ -0,0 +1,157 @@
+#include "../common/common.h"
+#include "../common/redis_test.h"
+#include "redis/redis_cluster.h"
+
+int slot(const char* key) {
+    return RedisCluster::key_slot(key, strlen(key));
+}
+
+/* find the key of the cmd encoded as hiredis does. */
+std::string cmd_key(const std::vector<std::string>& args) {
+    auto cmd = format_cmd(args);
+    std::string key("<none>");
+    const char* k = nullptr;
+    size_t k_len = 0;
+    if (RedisCluster::cmd_key(cmd.c_str(), cmd.size(), &k, &k_len)) {
+        key.assign(k, k_len);
+    }
+    return key;
+}
+
+int block_time(const std::vector<std::string>& args) {
+    auto cmd = format_cmd(args);
+    return RedisCluster::cmd_block_time(cmd.c_str(), cmd.size());
+}
+
+redisReply* new_range(long long start, long long end, const char* host, int port) {
+    redisReply* r = new_reply(REDIS_REPLY_ARRAY, 3);
+    r->element[0] = new_integer(start);
+    r->element[1] = new_integer(end);
+    r->element[2] = new_reply(REDIS_REPLY_ARRAY, 2);
+    r->element[2]->element[0] = new_string(host);
+    r->element[2]->element[1] = new_integer(port);
+    return r;
+}
+
+bool parse(const char* err, bool* is_ask, int* slot, RedisCluster::addr_t* addr) {
+    return RedisCluster::parse_redirect(err, strlen(err), "10.0.0.1", is_ask, slot, addr);
+}
+
+void test_key_slot() {
+    /* slots from redis cluster's spec and `CLUSTER KEYSLOT`. */
+    TEST_CHECK(slot("123456789") == 12739);
+    TEST_CHECK(slot("foo") == 12182);
+    TEST_CHECK(slot("bar") == 5061);
+    TEST_CHECK(slot("") == 0);
+
+    /* hash tag. */
+    TEST_CHECK(slot("{user1000}.following") == slot("user1000"));
+    TEST_CHECK(slot("{user1000}.following") == slot("{user1000}.followers"));
+    TEST_CHECK(slot("foo{}{bar}") != slot("bar"));
+    TEST_CHECK(slot("foo{{bar}}zap") == slot("{bar"));
+    TEST_CHECK(slot("foo{bar}{zap}") == slot("bar"));
+    TEST_CHECK(slot("{foo") != slot("foo"));
+}
+
+void test_cmd_key() {
+    TEST_CHECK(cmd_key({"GET", "foo"}) == "foo");
+    TEST_CHECK(cmd_key({"set", "{a}b", "value"}) == "{a}b");
+    TEST_CHECK(cmd_key({"HGET", "hash", "field"}) == "hash");
+    TEST_CHECK(cmd_key({"EVAL", "return 1", "1", "key", "arg"}) == "key");
+    TEST_CHECK(cmd_key({"evalsha", "sha1", "2", "k1", "k2"}) == "k1");
+    TEST_CHECK(cmd_key({"EVAL", "return 1", "0"}) == "<none>");
+    TEST_CHECK(cmd_key({"PING"}) == "<none>");
+}
+
+void test_cmd_block_time() {
+    TEST_CHECK(block_time({"GET", "foo"}) == 0);
+    TEST_CHECK(block_time({"BITCOUNT", "foo"}) == 0);
+    TEST_CHECK(block_time({"BLPOP", "k1", "k2", "5"}) == 5000);
+    TEST_CHECK(block_time({"brpoplpush", "src", "dst", "0.5"}) == 500);
+    TEST_CHECK(block_time({"BLPOP", "k", "0"}) == -1);
+    TEST_CHECK(block_time({"BLMPOP", "2", "1", "k", "LEFT"}) == 2000);
+    TEST_CHECK(block_time({"XREAD", "COUNT", "1", "BLOCK", "100", "STREAMS", "s", "$"}) == 100);
+    TEST_CHECK(block_time({"XREAD", "BLOCK", "0", "STREAMS", "s", "$"}) == -1);
+    TEST_CHECK(block_time({"XREAD", "STREAMS", "block", "1"}) == 0);
+    TEST_CHECK(block_time({"WAIT", "1", "200"}) == 200);
+    TEST_CHECK(block_time({"WAIT", "1", "0"}) == -1);
+}
+
+void test_parse_redirect() {
+    bool is_ask = true;
+    int slot = -1;
+    RedisCluster::addr_t addr;
+
+    TEST_CHECK(parse("MOVED 3999 127.0.0.1:6381", &is_ask, &slot, &addr));
+    TEST_CHECK(!is_ask && slot == 3999 && addr.host == "127.0.0.1" && addr.port == 6381);
+
+    TEST_CHECK(parse("ASK 16383 ::1:7000", &is_ask, &slot, &addr));
+    TEST_CHECK(is_ask && slot == 16383 && addr.host == "::1" && addr.port == 7000);
+
+    /* empty host: the same host as the replying node (redis 7). */
+    TEST_CHECK(parse("MOVED 3999 :6381", &is_ask, &slot, &addr));
+    TEST_CHECK(!is_ask && slot == 3999 && addr.host == "10.0.0.1" && addr.port == 6381);
+
+    TEST_CHECK(!parse("ERR unknown command", &is_ask, &slot, &addr));
+    TEST_CHECK(!parse("MOVED 3999", &is_ask, &slot, &addr));
+    TEST_CHECK(!parse("MOVED 16384 127.0.0.1:6381", &is_ask, &slot, &addr));
+    TEST_CHECK(!parse("MOVED 3999 127.0.0.1:0", &is_ask, &slot, &addr));
+    TEST_CHECK(!RedisCluster::parse_redirect(nullptr, 0, "10.0.0.1", &is_ask, &slot, &addr));
+}
+
+void test_slot_map() {
+    RedisCluster cluster("127.0.0.1", 7000);
+    TEST_CHECK(!cluster.is_ready());
+
+    /* unknown slot goes to the seed node. */
+    TEST_CHECK(cluster.owner(100).port == 7000);
+
+    RedisCluster::addr_t addr;
+    addr.host = "127.0.0.1";
+    addr.port = 7001;
+    cluster.set_owner(100, addr);
+    TEST_CHECK(cluster.owner(100).port == 7001);
+    TEST_CHECK(cluster.owner(101).port == 7000);
+    TEST_CHECK(cluster.masters().size() == 1);
+
+    /* CLUSTER SLOTS, the master without host is the replying node. */
+    redisReply* r = new_reply(REDIS_REPLY_ARRAY, 3);
+    r->element[0] = new_range(0, 5460, "127.0.0.1", 7000);
+    r->element[1] = new_range(5461, 10922, "127.0.0.1", 7001);
+    r->element[2] = new_range(10923, 16383, "", 7002);
+    TEST_CHECK(cluster.update(r, "10.0.0.1"));
+    freeReplyObject(r);
+
+    TEST_CHECK(cluster.is_ready() && cluster.masters().size() == 3);
+    TEST_CHECK(cluster.owner(0).port == 7000 && cluster.owner(5460).port == 7000);
+    TEST_CHECK(cluster.owner(5461).port == 7001 && cluster.owner(10922).port == 7001);
+    TEST_CHECK(cluster.owner(16383).port == 7002 && cluster.owner(16383).host == "10.0.0.1");
+    TEST_CHECK(cluster.owner(slot("foo")).port == 7002);
+
+    /* MOVED updates one slot. */
+    cluster.set_owner(slot("foo"), cluster.owner(0));
+    TEST_CHECK(cluster.owner(slot("foo")).port == 7000);
+    TEST_CHECK(cluster.owner(slot("foo") + 1).port == 7002);
+
+    /* invalid reply keeps the map. */
+    r = new_reply(REDIS_REPLY_ARRAY, 1);
+    r->element[0] = new_integer(1);
+    TEST_CHECK(!cluster.update(r, "10.0.0.1"));
+    freeReplyObject(r);
+    TEST_CHECK(cluster.owner(0).port == 7000 && cluster.masters().size() == 3);
+}
+
+int main(int argc, char** argv) {
+    test_key_slot();
+    test_cmd_key();
+    test_cmd_block_time();
+    test_parse_redirect();
+    test_slot_map();
+
+    if (g_fail_cnt > 0) {
+        printf("test redis cluster failed! fail cnt: %d\n", g_fail_cnt);
+        return -1;
+    }
+    printf("test redis cluster done!\n");
+    return 0;
+}
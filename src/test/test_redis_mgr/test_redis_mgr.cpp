@@ -41,7 +41,6 @@ void* co_handler() {
 
     int i, ret;
     double spend;
-    char cmd[256];
     redisReply* reply = nullptr;
     const char* node = "test";
     const char* key = "key111";
@@ -49,13 +48,11 @@ void* co_handler() {
 
     for (i = 0; i < g_co_cmd_cnt; i++) {
         if (g_is_read) {
-            snprintf(cmd, sizeof(cmd), "get %s", key);
+            ret = g_redis_mgr->exec_cmd_args(node, &reply, "get", key);
         } else {
-            snprintf(cmd, sizeof(cmd), "set %s %s:%d", key, val, i);
+            ret = g_redis_mgr->exec_cmd_args(node, &reply, "set", key, format_str("%s:%d", val, i));
         }
 
-        ret = g_redis_mgr->exec_cmd(node, cmd, &reply);
-
         g_cur_test_cnt++;
         if (ret == ERR_OK) {
             g_cur_success_cnt++;
@@ -10,10 +10,12 @@ std::list<test_task_t*> g_free_tasks;
 
 void create_timer_co();
 void test_session_mgr(int cnt);
+void test_touch_session();
 bool init(int argc, char** argv);
 
 void co_timer();
 void co_session(void* arg);
+void co_touch_session();
 
 int main(int argc, char** argv) {
     if (!init(argc, argv)) {
@@ -21,6 +23,7 @@ int main(int argc, char** argv) {
     }
     create_timer_co();
     test_session_mgr(atoi(argv[1]));
+    test_touch_session();
     co_eventloop(co_get_epoll_ct());
     return 0;
 }
@@ -68,6 +71,53 @@ void co_session(void* arg) {
     g_free_tasks.push_back(task);
 }
 
+void test_touch_session() {
+    stCoRoutine_t* co;
+    co_create(&co, NULL, [](void*) { co_touch_session(); });
+    co_resume(co);
+}
+
+/* the touched session lives longer than its timeout, it times out after touching stops. */
+void co_touch_session() {
+    co_enable_hook_sys();
+
+    std::string sessid("touch");
+    uint64_t after = 2 * 1000;
+
+    auto sess = g_session_mgr->get_alloc_session<UserSession>(sessid, after);
+    if (sess == nullptr) {
+        LOG_ERROR("get sess failed! sessid: %s", sessid.c_str());
+        return;
+    }
+    sess = nullptr;
+
+    for (int i = 0; i < 5; i++) {
+        co_sleep(after / 2);
+        if (!g_session_mgr->touch_session(sessid)) {
+            LOG_ERROR("touch session failed! sessid: %s, i: %d", sessid.c_str(), i);
+            printf("test touch session failed!\n");
+            return;
+        }
+    }
+
+    co_sleep(after / 2);
+    if (g_session_mgr->get_session(sessid) == nullptr) {
+        LOG_ERROR("touched session timeout too early! sessid: %s", sessid.c_str());
+        printf("test touch session failed!\n");
+        return;
+    }
+
+    co_sleep(after);
+    if (g_session_mgr->get_session(sessid) != nullptr ||
+        g_session_mgr->touch_session(sessid)) {
+        LOG_ERROR("session does not timeout! sessid: %s", sessid.c_str());
+        printf("test touch session failed!\n");
+        return;
+    }
+
+    printf("test touch session done!\n");
+}
+
 void co_timer() {
     co_enable_hook_sys();
 
@@ -343,14 +343,11 @@ Codec::STATUS send_proto(std::shared_ptr<Connection> c, int cmd, const std::stri
     auto msg = std::make_shared<Msg>(c->ft());
 
     msg->body()->set_data(data);
-    auto body_len = msg->body()->ByteSizeLong();
-
     msg->head()->set_cmd(cmd);
     msg->head()->set_seq(new_seq());
-    msg->head()->set_len(body_len);
 
-    LOG_DEBUG("send fd: %d, seq: %d, body len: %d, data: <%s>",
-              c->fd(), msg->head()->seq(), body_len, msg->body()->data().c_str());
+    LOG_DEBUG("send fd: %d, seq: %d, data len: %lu, data: <%s>",
+              c->fd(), msg->head()->seq(), data.size(), msg->body()->data().c_str());
     return c->conn_write(msg);
 }
 
@@ -6,6 +6,7 @@ std::map<int, char*> g_datas;
 
 void test_timer1(int tid, bool is_repeat, void* privdata);
 void test_timer2(int tid, bool is_repeat, void* privdata);
+bool test_wheel(uint64_t start);
 
 int main(int argc, char** argv) {
     if (argc != 2) {
@@ -17,6 +18,11 @@ int main(int argc, char** argv) {
         return -1;
     }
 
+    /* test timer wheel, not aligned and aligned to the levels. */
+    if (!test_wheel(123456789) || !test_wheel(1ULL << 32)) {
+        return -1;
+    }
+
     g_timers = new Timers(m_logger);
     if (!g_timers->init_timer()) {
         return -1;
@@ -42,6 +48,12 @@ int main(int argc, char** argv) {
     // }
     // g_datas.clear();
 
+    /* test long timer, it is cascaded from the higher levels. */
+    data = new char[64];
+    snprintf(data, 64, "long timer, hello world");
+    id = g_timers->add_timer(&test_timer1, 70 * 1000, 0, data);
+    g_datas[id] = data;
+
     /* test repeat timer. */
     data = new char[64];
     snprintf(data, 64, "repeat hello world");
@@ -66,4 +78,61 @@ void test_timer2(int tid, bool is_repeat, void* privdata) {
     if (privdata != nullptr) {
         printf("tid: %d, %s\n", tid, (char*)privdata);
     }
-}
\ No newline at end of file
+}
+/* every node must be popped exactly at its due tick, the long ones (> 2^16 ms)
+ * and the ones due at the levels' boundaries are cascaded before. */
+bool test_wheel(uint64_t start) {
+    const int bits = TimerWheel::LEVEL_BITS;
+    uint64_t afters[] = {
+        1, 2, 255, 256, 257,
+        (1ULL << (bits * 2)) - 1, 1ULL << (bits * 2), (1ULL << (bits * 2)) + 1,
+        70 * 1000, 1000 * 1000,
+        (1ULL << (bits * 3)) - 1, 1ULL << (bits * 3), (1ULL << (bits * 3)) + 1,
+        (1ULL << (bits * 4)) + 5 /* out of the wheel's range. */
+    };
+    int cnt = sizeof(afters) / sizeof(afters[0]);
+
+    TimerWheel wheel(start);
+    std::vector<TimerNode> nodes(cnt);
+    for (int i = 0; i < cnt; i++) {
+        wheel.add(&nodes[i], start + afters[i]);
+    }
+
+    /* rescheduled node, like touching a session. */
+    TimerNode touched;
+    wheel.add(&touched, start + 100);
+    wheel.mod(&touched, start + (1ULL << (bits * 2)) + 100);
+
+    for (int i = 0; i < cnt; i++) {
+        uint64_t expire = start + afters[i];
+        if (expire > touched.expire_time() && touched.is_pending()) {
+            if (wheel.pop_expired(touched.expire_time() - 1) != nullptr ||
+                wheel.pop_expired(touched.expire_time()) != &touched) {
+                printf("touched timer failed! start: %llu\n", (unsigned long long)start);
+                return false;
+            }
+        }
+
+        TimerNode* node = wheel.pop_expired(expire - 1);
+        if (node != nullptr) {
+            printf("timer is early! start: %llu, expire: %llu, now: %llu\n",
+                   (unsigned long long)start, (unsigned long long)node->expire_time(),
+                   (unsigned long long)(expire - 1));
+            return false;
+        }
+        node = wheel.pop_expired(expire);
+        if (node != &nodes[i]) {
+            printf("timer is late! start: %llu, after: %llu\n",
+                   (unsigned long long)start, (unsigned long long)afters[i]);
+            return false;
+        }
+    }
+
+    if (wheel.size() != 0) {
+        printf("timer wheel is not empty! size: %lu\n", wheel.size());
+        return false;
+    }
+
+    printf("test timer wheel done! start: %llu\n", (unsigned long long)start);
+    return true;
+}
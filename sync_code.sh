@@ -34,4 +34,6 @@ rsync -avz --exclude="*.o" \
     --exclude="test/test_session/test_session" \
     --exclude="test/test_timers/test_timers" \
     --exclude="test/test_json/test_json" \
+    --exclude="test/test_redis_cluster/test_redis_cluster" \
+    --exclude="test/test_redis_cache/test_redis_cache" \
     $SRC $DST